@@ -89,6 +89,7 @@ testScriptsExt=(
     'forknotify.py'
     'hardforkdetection.py'
     'invalidateblock.py'
+    'coinsupply_reorg.py'
     'keypool.py'
     'receivedby.py'
     'rpcbind_test.py'
@@ -25,6 +25,7 @@ class BlockchainTest(BitcoinTestFramework):
     Test blockchain-related RPC calls:
 
         - gettxoutsetinfo
+        - invalidateblock, reconsiderblock (for the running UTXO set statistics)
 
     """
 
@@ -48,7 +49,33 @@ class BlockchainTest(BitcoinTestFramework):
         assert_equal(res[u'txouts'], 349) # 150*2 + 49
         assert_equal(res[u'bytes_serialized'], 14951), # 32*199 + 48*90 + 49*60 + 27*49
         assert_equal(len(res[u'bestblock']), 64)
-        assert_equal(len(res[u'hash_serialized']), 64)
+        assert_equal(len(res[u'muhash']), 64)
+        assert(u'hash_serialized' not in res)
+
+        # a full scan also returns the serialized hash
+        full = node.gettxoutsetinfo(True)
+        assert_equal(len(full[u'hash_serialized']), 64)
+        self.check_running_stats(node)
+
+        # the running statistics follow blocks being disconnected and connected again
+        tiphash = node.getbestblockhash()
+        badhash = node.getblockhash(195)
+        node.invalidateblock(badhash)
+        assert_equal(node.getblockcount(), 194)
+        self.check_running_stats(node)
+        assert(node.gettxoutsetinfo()[u'muhash'] != res[u'muhash'])
+
+        node.reconsiderblock(badhash)
+        assert_equal(node.getbestblockhash(), tiphash)
+        self.check_running_stats(node)
+        assert_equal(node.gettxoutsetinfo()[u'muhash'], res[u'muhash'])
+
+    def check_running_stats(self, node):
+        res = node.gettxoutsetinfo()
+        full = node.gettxoutsetinfo(True)
+        for field in [u'height', u'bestblock', u'transactions', u'txouts',
+                      u'bytes_serialized', u'muhash', u'total_amount']:
+            assert_equal(res[field], full[field])
 
 
 if __name__ == '__main__':
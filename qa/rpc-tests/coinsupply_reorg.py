@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+# Copyright (c) 2020 The Zcash developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#
+# Test that the coin supply stored in the block index survives a block being
+# disconnected and connected again
+#
+
+import sys; assert sys.version_info < (3,), ur"This script does not run under Python 3. Please use Python 2.7.x."
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, initialize_chain_clean, \
+    start_nodes, connect_nodes_bi, sync_blocks
+
+COINBASE_MATURITY = 100
+
+class CoinSupplyReorgTest(BitcoinTestFramework):
+    def setup_chain(self):
+        print("Initializing test directory "+self.options.tmpdir)
+        initialize_chain_clean(self.options.tmpdir, 2)
+
+    def setup_network(self):
+        self.nodes = start_nodes(2, self.options.tmpdir, [["-debug"]] * 2)
+        self.is_network_split = True
+
+    def run_test(self):
+        print "Mine 5 blocks on node 0, then disconnect and reconnect blocks 3 to 5"
+        self.nodes[0].generate(5)
+        self.nodes[0].invalidateblock(self.nodes[0].getblockhash(3))
+        assert_equal(self.nodes[0].getblockcount(), 2)
+        self.nodes[0].reconsiderblock(self.nodes[0].getblockhash(3))
+        assert_equal(self.nodes[0].getblockcount(), 5)
+
+        print "Mine until the coinbases of the reconnected blocks have matured"
+        self.nodes[0].generate(COINBASE_MATURITY + 5)
+
+        print "Sync node 1, which connects every block once, and compare the supply at each height"
+        connect_nodes_bi(self.nodes, 0, 1)
+        sync_blocks(self.nodes)
+        for height in range(1, self.nodes[0].getblockcount() + 1):
+            supply0 = self.nodes[0].coinsupply(str(height))
+            supply1 = self.nodes[1].coinsupply(str(height))
+            for field in ["supply", "immature", "zfunds", "total"]:
+                assert_equal(supply0[field], supply1[field])
+
+        # only the coinbases of the last COINBASE_MATURITY blocks are immature at the tip
+        tip = self.nodes[0].getblockcount()
+        matured = self.nodes[0].coinsupply(str(tip - COINBASE_MATURITY))
+        assert_equal(self.nodes[0].coinsupply(str(tip))["immature"],
+                     self.nodes[0].coinsupply(str(tip))["supply"] - matured["supply"])
+
+if __name__ == '__main__':
+    CoinSupplyReorgTest().main()
@@ -51,26 +51,48 @@ struct CAddressUnspentKey {
         txhash.SetNull();
         index = 0;
     }
+
+    bool operator==(const CAddressUnspentKey &other) const {
+        return type == other.type && hashBytes == other.hashBytes && txhash == other.txhash && index == other.index;
+    }
 };
 
 struct CAddressUnspentValue {
     CAmount satoshis;
     CScript script;
-    int blockHeight;
+    int blockHeight;            // height the output is indexed at, which index height offsets may move from the block
+    int confirmedHeight;        // height of the block that confirmed the output
+    uint256 blockHash;          // hash of that block, null in records written before it was added
 
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(satoshis);
-        READWRITE(*(CScriptBase*)(&script));
-        READWRITE(blockHeight);
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::Serialize(s, satoshis);
+        ::Serialize(s, *(CScriptBase*)(&script));
+        ::Serialize(s, blockHeight);
+        ::Serialize(s, confirmedHeight);
+        blockHash.Serialize(s);
     }
-
-    CAddressUnspentValue(CAmount sats, CScript scriptPubKey, int height) {
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::Unserialize(s, satoshis);
+        ::Unserialize(s, *(CScriptBase*)(&script));
+        ::Unserialize(s, blockHeight);
+        // older records end here, and are given their block by UpgradeAddressUnspentIndex
+        if (s.empty()) {
+            confirmedHeight = 0;
+            blockHash.SetNull();
+        } else {
+            ::Unserialize(s, confirmedHeight);
+            blockHash.Unserialize(s);
+        }
+    }
+
+    CAddressUnspentValue(CAmount sats, CScript scriptPubKey, int height, int confirmed, const uint256 &hash) {
         satoshis = sats;
         script = scriptPubKey;
         blockHeight = height;
+        confirmedHeight = confirmed;
+        blockHash = hash;
     }
 
     CAddressUnspentValue() {
@@ -81,11 +103,17 @@ struct CAddressUnspentValue {
         satoshis = -1;
         script.clear();
         blockHeight = 0;
+        confirmedHeight = 0;
+        blockHash.SetNull();
     }
 
     bool IsNull() const {
         return (satoshis == -1);
     }
+
+    bool HasBlock() const {
+        return !blockHash.IsNull();
+    }
 };
 
 struct CAddressIndexKey {
@@ -149,6 +177,10 @@ struct CAddressIndexKey {
         spending = false;
     }
 
+    bool operator==(const CAddressIndexKey &other) const {
+        return type == other.type && hashBytes == other.hashBytes && blockHeight == other.blockHeight && txindex == other.txindex &&
+               txhash == other.txhash && index == other.index && spending == other.spending;
+    }
 };
 
 struct CAddressIndexIteratorKey {
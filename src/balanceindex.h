@@ -0,0 +1,113 @@
+// Copyright (c) 2022 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_BALANCEINDEX_H
+#define BITCOIN_BALANCEINDEX_H
+
+#include "amount.h"
+#include "uint256.h"
+#include "pbaas/crosschainrpc.h"
+
+// indexes the current balance and total received of each address, in the native currency and in reserve currencies,
+// as the sum of all of its address index entries
+struct CAddressBalanceKey {
+    unsigned int type;
+    uint160 hashBytes;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return 21;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+    }
+
+    CAddressBalanceKey(unsigned int addressType, const uint160 &addressHash) {
+        type = addressType;
+        hashBytes = addressHash;
+    }
+
+    CAddressBalanceKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+    }
+
+    bool operator<(const CAddressBalanceKey &other) const {
+        return type < other.type || (type == other.type && hashBytes < other.hashBytes);
+    }
+};
+
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+    CCurrencyValueMap reserveBalance;
+    CCurrencyValueMap reserveReceived;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(reserveBalance);
+        READWRITE(reserveReceived);
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        reserveBalance = CCurrencyValueMap();
+        reserveReceived = CCurrencyValueMap();
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0 && reserveBalance.valueMap.empty() && reserveReceived.valueMap.empty();
+    }
+
+    // adds or, when disconnecting a block, removes the changes of another value
+    void Apply(const CAddressBalanceValue &delta, bool fConnect) {
+        if (fConnect) {
+            balance += delta.balance;
+            received += delta.received;
+            reserveBalance += delta.reserveBalance;
+            reserveReceived += delta.reserveReceived;
+            return;
+        }
+        balance -= delta.balance;
+        received -= delta.received;
+        reserveBalance -= delta.reserveBalance;
+        reserveReceived -= delta.reserveReceived;
+
+        // a currency that is left with nothing received was only seen in the disconnected block
+        CCurrencyValueMap keptBalance, keptReceived;
+        for (auto &oneVal : reserveReceived.valueMap) {
+            if (oneVal.second) {
+                keptReceived.valueMap.push_back(oneVal);
+            }
+        }
+        for (auto &oneVal : reserveBalance.valueMap) {
+            if (keptReceived.valueMap.count(oneVal.first)) {
+                keptBalance.valueMap.push_back(oneVal);
+            }
+        }
+        reserveBalance = keptBalance;
+        reserveReceived = keptReceived;
+    }
+};
+
+#endif // BITCOIN_BALANCEINDEX_H
@@ -14,7 +14,9 @@ class CChainPower;
 #include "tinyformat.h"
 #include "uint256.h"
 #include "mmr.h"
+#include "pbaas/crosschainrpc.h"
 
+#include <memory>
 #include <vector>
 
 static const int SPROUT_VALUE_VERSION = 1001400;
@@ -152,6 +154,8 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_ACTIVATES_UPGRADE  =   128, //! block activates a network upgrade
+
+    BLOCK_HAVE_SUPPLY        =   256, //! the coin supply of the chain up to this block is stored in the index
 };
 
 //! Short-hand for the highest consensus validity we implement.
@@ -278,6 +282,15 @@ public:
     int64_t immature;       // how much in this block is immature
     uint32_t maturity;      // when do the immature funds in this block mature?
 
+    //! Coin supply of the chain ending at this block, only set if nStatus has BLOCK_HAVE_SUPPLY. The supply
+    //! only depends on the block's ancestors, so it stays valid when the block is disconnected.
+    CAmount nChainTransparentSupply;    // transparent coins, including immature coinbase outputs
+    CAmount nChainShieldedSupply;       // coins in the Sprout and Sapling pools
+    CAmount nChainImmatureSupply;       // coinbase outputs that have not matured at this height
+    //! Net amount of each other currency in transparent outputs, which imports create and burns destroy. Blocks
+    //! that do not change it share their parent's map, and it is null until any currency is issued.
+    std::shared_ptr<const CCurrencyValueMap> pChainCurrencySupply;
+
     int8_t segid; // jl777 fields
 
     //! Which # file this block is stored in (blk?????.dat)
@@ -351,6 +364,10 @@ public:
         newcoins = zfunds = 0;
         maturity = 0;
         immature = 0;
+        nChainTransparentSupply = 0;
+        nChainShieldedSupply = 0;
+        nChainImmatureSupply = 0;
+        pChainCurrencySupply.reset();
         segid = -2;
         pprev = NULL;
         pskip = NULL;
@@ -582,6 +599,13 @@ public:
 /** Used to marshal pointers into hashes for db storage. */
 class CDiskBlockIndex : public CBlockIndex
 {
+private:
+    // whether a record being read has more fields, which only disk reads ask
+    template <typename Stream>
+    static bool HasMoreFields(Stream& s, CSerActionUnserialize) { return !s.empty(); }
+    template <typename Stream>
+    static bool HasMoreFields(Stream& s, CSerActionSerialize) { return false; }
+
 public:
     uint256 hashPrev;
 
@@ -671,6 +695,36 @@ public:
             READWRITE(nSaplingValue);
         }
 
+        // the supply fields follow everything else, so older versions read these records and ignore them. as for the block
+        // hash of CDiskTxPos, they are read if the record has them, since an older version that rewrites a record keeps
+        // BLOCK_HAVE_SUPPLY in its status but drops the fields.
+        if ((s.GetType() & SER_DISK) && ser_action.ForRead()) {
+            if (HasMoreFields(s, ser_action))
+                nStatus |= BLOCK_HAVE_SUPPLY;
+            else
+                nStatus &= ~BLOCK_HAVE_SUPPLY;
+        }
+        if ((s.GetType() & SER_DISK) && (nStatus & BLOCK_HAVE_SUPPLY)) {
+            READWRITE(newcoins);
+            READWRITE(zfunds);
+            READWRITE(immature);
+            READWRITE(maturity);
+            READWRITE(nChainTransparentSupply);
+            READWRITE(nChainShieldedSupply);
+            READWRITE(nChainImmatureSupply);
+            if (ser_action.ForRead()) {
+                CCurrencyValueMap currencySupply;
+                READWRITE(currencySupply);
+                if (currencySupply.valueMap.size())
+                    pChainCurrencySupply = std::make_shared<const CCurrencyValueMap>(currencySupply);
+                else
+                    pChainCurrencySupply.reset();
+            } else {
+                CCurrencyValueMap currencySupply = pChainCurrencySupply ? *pChainCurrencySupply : CCurrencyValueMap();
+                READWRITE(currencySupply);
+            }
+        }
+
         // If you have just added new serialized fields above, remember to add
         // them to CBlockTreeDB::LoadBlockIndexGuts() in txdb.cpp :)
     }
@@ -347,8 +347,10 @@ struct CCoinsStats
     uint64_t nTransactions;
     uint64_t nTransactionOutputs;
     uint64_t nSerializedSize;
-    uint256 hashSerialized;
+    uint256 hashSerialized;         //!< hash of the set in key order, only set by a full scan
+    uint256 hashMuHash;             //!< order independent hash of the set, only set when it is kept up to date
     CAmount nTotalAmount;
+    CCurrencyValueMap reserveAmounts;
 
     CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nSerializedSize(0), nTotalAmount(0) {}
 };
@@ -394,6 +396,9 @@ public:
     //! Calculate statistics about the unspent transaction output set
     virtual bool GetStats(CCoinsStats &stats) const;
 
+    //! Calculate statistics about the unspent transaction output set, including its serialized hash, from a full scan
+    virtual bool ScanStats(CCoinsStats &stats) const;
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 };
@@ -424,6 +429,7 @@ public:
                     CNullifiersMap &mapSproutNullifiers,
                     CNullifiersMap &mapSaplingNullifiers);
     bool GetStats(CCoinsStats &stats) const;
+    bool ScanStats(CCoinsStats &stats) const;
 };
 
 
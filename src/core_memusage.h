@@ -25,6 +25,20 @@ static inline size_t RecursiveDynamicUsage(const CTxOut& out) {
     return RecursiveDynamicUsage(out.scriptPubKey);
 }
 
+static inline size_t RecursiveDynamicUsage(const COptCCParams& p) {
+    size_t mem = memusage::DynamicUsage(p.vKeys) + memusage::DynamicUsage(p.vData);
+    for (std::vector<std::vector<unsigned char>>::const_iterator it = p.vData.begin(); it != p.vData.end(); it++) {
+        mem += memusage::DynamicUsage(*it);
+    }
+    return mem;
+}
+
+static inline size_t RecursiveDynamicUsage(const CTxOutDescriptor& desc) {
+    size_t decodedSize = desc.DecodedSize();
+    return RecursiveDynamicUsage(desc.p) +
+           (decodedSize ? memusage::MallocUsage(sizeof(CTxOutDescriptor::CDecodedObject)) + memusage::MallocUsage(decodedSize) : 0);
+}
+
 static inline size_t RecursiveDynamicUsage(const CTransaction& tx) {
     size_t mem = memusage::DynamicUsage(tx.vin) + memusage::DynamicUsage(tx.vout);
     for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); it++) {
@@ -33,6 +47,14 @@ static inline size_t RecursiveDynamicUsage(const CTransaction& tx) {
     for (std::vector<CTxOut>::const_iterator it = tx.vout.begin(); it != tx.vout.end(); it++) {
         mem += RecursiveDynamicUsage(*it);
     }
+    // parsed outputs are shared between copies of a transaction, and each copy is charged for them
+    std::shared_ptr<const std::vector<CTxOutDescriptor>> descriptors = tx.GetOutputDescriptors();
+    if (descriptors) {
+        mem += memusage::DynamicUsage(descriptors) + memusage::DynamicUsage(*descriptors);
+        for (std::vector<CTxOutDescriptor>::const_iterator it = descriptors->begin(); it != descriptors->end(); it++) {
+            mem += RecursiveDynamicUsage(*it);
+        }
+    }
     return mem;
 }
 
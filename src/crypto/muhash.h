@@ -0,0 +1,89 @@
+// Copyright (c) 2017-2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_CRYPTO_MUHASH_H
+#define BITCOIN_CRYPTO_MUHASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** A number modulo the prime 2^3072 - 1103717, stored as little endian 64 bit limbs. */
+class Num3072
+{
+private:
+    void FullReduce();
+    bool IsOverflow() const;
+    Num3072 GetInverse() const;
+
+public:
+    static const size_t BYTE_SIZE = 384;
+    static const int LIMBS = 48;
+    uint64_t limbs[LIMBS];
+
+    // Sets this to a * this modulo the prime
+    void Multiply(const Num3072& a);
+    // Sets this to this / a modulo the prime
+    void Divide(const Num3072& a);
+    void SetToOne();
+    void ToBytes(unsigned char (&out)[BYTE_SIZE]) const;
+
+    Num3072() { SetToOne(); }
+    explicit Num3072(const unsigned char (&data)[BYTE_SIZE]);
+};
+
+/** A rolling hash of a multiset of byte strings, which does not depend on the order they are added in.
+ *
+ *  Each element is hashed to a number modulo a 3072 bit prime, and the set's hash is the product of its elements'
+ *  numbers. Removing an element divides by its number, so a set can be maintained incrementally, and two sets
+ *  built in any order hash the same. The numerator and denominator are kept separately, so the only modular
+ *  inverse is in Finalize.
+ */
+class MuHash3072
+{
+private:
+    Num3072 numerator;
+    Num3072 denominator;
+
+    static Num3072 ToNum3072(const unsigned char* data, size_t len);
+
+public:
+    static const size_t OUTPUT_SIZE = 32;
+
+    MuHash3072() {}
+
+    // Adds or removes an element, which must be in the set to be removed
+    MuHash3072& Insert(const unsigned char* data, size_t len);
+    MuHash3072& Remove(const unsigned char* data, size_t len);
+
+    // Combines with the hash of another set, or removes the elements of a set that is contained in this one
+    MuHash3072& operator*=(const MuHash3072& mul);
+    MuHash3072& operator/=(const MuHash3072& div);
+
+    // SHA256 of the normalized product, which does not change the state
+    void Finalize(unsigned char hash[OUTPUT_SIZE]) const;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return 2 * Num3072::BYTE_SIZE;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        unsigned char data[Num3072::BYTE_SIZE];
+        numerator.ToBytes(data);
+        s.write((const char*)data, sizeof(data));
+        denominator.ToBytes(data);
+        s.write((const char*)data, sizeof(data));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        unsigned char data[Num3072::BYTE_SIZE];
+        s.read((char*)data, sizeof(data));
+        numerator = Num3072(data);
+        s.read((char*)data, sizeof(data));
+        denominator = Num3072(data);
+    }
+};
+
+#endif // BITCOIN_CRYPTO_MUHASH_H
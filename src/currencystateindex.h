@@ -0,0 +1,50 @@
+// Copyright (c) 2022 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_CURRENCYSTATEINDEX_H
+#define BITCOIN_CURRENCYSTATEINDEX_H
+
+#include "uint256.h"
+
+// indexes the last notarization of a currency in each block, which carries its currency state. the serialized
+// notarization is stored as the value
+struct CCurrencyStateIndexKey {
+    uint160 currencyID;
+    unsigned int blockHeight;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return 24;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        currencyID.Serialize(s);
+        // Heights are stored big-endian for key sorting in LevelDB
+        ser_writedata32be(s, blockHeight);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        currencyID.Unserialize(s);
+        blockHeight = ser_readdata32be(s);
+    }
+
+    CCurrencyStateIndexKey(const uint160 &currency, unsigned int height) {
+        currencyID = currency;
+        blockHeight = height;
+    }
+
+    CCurrencyStateIndexKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        currencyID.SetNull();
+        blockHeight = 0;
+    }
+
+    bool operator<(const CCurrencyStateIndexKey &other) const {
+        return currencyID < other.currencyID || (currencyID == other.currencyID && blockHeight < other.blockHeight);
+    }
+};
+
+#endif // BITCOIN_CURRENCYSTATEINDEX_H
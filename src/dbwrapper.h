@@ -78,6 +78,11 @@ public:
 
         batch.Delete(slKey);
     }
+
+    void Clear()
+    {
+        batch.Clear();
+    }
 };
 
 class CDBIterator
@@ -112,6 +117,16 @@ public:
     void Next();
     void Prev();
 
+    //! Position at the last entry before key, or the last entry if there is none after it, to walk a range back with Prev()
+    template<typename K> void SeekBefore(const K& key) {
+        Seek(key);
+        if (Valid()) {
+            Prev();
+        } else {
+            SeekToLast();
+        }
+    }
+
     template<typename K> bool GetKey(K& key) {
         leveldb::Slice slKey = piter->key();
         try {
@@ -0,0 +1,186 @@
+// Copyright (c) 2021 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_FLATMAP_H
+#define BITCOIN_FLATMAP_H
+
+#include "prevector.h"
+#include "serialize.h"
+
+#include <map>
+#include <utility>
+
+/** Implements a replacement for std::map<K, V> as a vector of entries sorted
+ *  by key, which stores up to N entries without heap allocation. Lookups are
+ *  binary searches and iteration walks contiguous memory in key order, the
+ *  same order that std::map would use.
+ *
+ *  Unlike std::map, inserting or erasing an entry invalidates iterators and
+ *  references to other entries, so a map must not be modified while it is
+ *  being iterated. Keys of entries are also not const, and must not be
+ *  changed through an iterator.
+ *
+ *  Serialization is identical to that of std::map<K, V>, including keeping
+ *  the first of any duplicate keys when deserializing.
+ *
+ *  K and V must be movable by memmove/realloc(), as for prevector.
+ */
+template<unsigned int N, typename K, typename V>
+class flatmap {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<K, V> value_type;
+    typedef prevector<N, value_type> vector_type;
+    typedef typename vector_type::size_type size_type;
+    typedef typename vector_type::iterator iterator;
+    typedef typename vector_type::const_iterator const_iterator;
+    typedef typename vector_type::reverse_iterator reverse_iterator;
+    typedef typename vector_type::const_reverse_iterator const_reverse_iterator;
+
+private:
+    vector_type entries;
+
+    // index of the first entry with a key that is not less than key
+    size_type lower_index(const K& key) const {
+        size_type first = 0, count = entries.size();
+        while (count > 0) {
+            size_type step = count >> 1;
+            if (entries[first + step].first < key) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+public:
+    flatmap() {}
+
+    flatmap(const std::map<K, V>& m) {
+        entries.reserve(m.size());
+        for (typename std::map<K, V>::const_iterator it = m.begin(); it != m.end(); ++it) {
+            entries.push_back(value_type(it->first, it->second));
+        }
+    }
+
+    template<typename InputIterator>
+    flatmap(InputIterator first, InputIterator last) {
+        while (first != last) {
+            insert(*first);
+            ++first;
+        }
+    }
+
+    size_type size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+    void reserve(size_type n) { entries.reserve(n); }
+
+    iterator begin() { return entries.begin(); }
+    const_iterator begin() const { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator end() const { return entries.end(); }
+    reverse_iterator rbegin() { return entries.rbegin(); }
+    const_reverse_iterator rbegin() const { return entries.rbegin(); }
+    reverse_iterator rend() { return entries.rend(); }
+    const_reverse_iterator rend() const { return entries.rend(); }
+
+    iterator lower_bound(const K& key) { return entries.begin() + lower_index(key); }
+    const_iterator lower_bound(const K& key) const { return entries.begin() + lower_index(key); }
+
+    iterator find(const K& key) {
+        size_type i = lower_index(key);
+        return (i < entries.size() && !(key < entries[i].first)) ? entries.begin() + i : entries.end();
+    }
+
+    const_iterator find(const K& key) const {
+        size_type i = lower_index(key);
+        return (i < entries.size() && !(key < entries[i].first)) ? entries.begin() + i : entries.end();
+    }
+
+    size_type count(const K& key) const {
+        size_type i = lower_index(key);
+        return (i < entries.size() && !(key < entries[i].first)) ? 1 : 0;
+    }
+
+    V& operator[](const K& key) {
+        size_type i = lower_index(key);
+        if (i == entries.size() || key < entries[i].first) {
+            entries.insert(entries.begin() + i, value_type(key, V()));
+        }
+        return entries.begin()[i].second;
+    }
+
+    template<typename P>
+    std::pair<iterator, bool> insert(const P& entry) {
+        K key = entry.first;
+        size_type i = lower_index(key);
+        if (i < entries.size() && !(key < entries[i].first)) {
+            return std::make_pair(entries.begin() + i, false);
+        }
+        return std::make_pair(entries.insert(entries.begin() + i, value_type(key, entry.second)), true);
+    }
+
+    /** Appends an entry with a key greater than all keys in the map, which
+     *  is how merges build their results without searching. */
+    void push_back(const value_type& entry) {
+        assert(entries.empty() || entries.back().first < entry.first);
+        entries.push_back(entry);
+    }
+
+    iterator erase(iterator pos) { return entries.erase(pos); }
+
+    size_type erase(const K& key) {
+        iterator it = find(key);
+        if (it == entries.end()) {
+            return 0;
+        }
+        entries.erase(it);
+        return 1;
+    }
+
+    void swap(flatmap& other) { entries.swap(other.entries); }
+
+    bool operator==(const flatmap& other) const { return entries == other.entries; }
+    bool operator!=(const flatmap& other) const { return entries != other.entries; }
+
+    operator std::map<K, V>() const {
+        std::map<K, V> m;
+        for (const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            m.insert(m.end(), *it);
+        }
+        return m;
+    }
+
+    size_t allocated_memory() const { return entries.allocated_memory(); }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        WriteCompactSize(s, entries.size());
+        for (const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            ::Serialize(s, *it);
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        entries.clear();
+        unsigned int nSize = ReadCompactSize(s);
+        for (unsigned int i = 0; i < nSize; i++) {
+            value_type item;
+            ::Unserialize(s, item);
+            // serialized maps are sorted, so this normally appends
+            if (entries.empty() || entries.back().first < item.first) {
+                entries.push_back(item);
+            } else {
+                insert(item);
+            }
+        }
+    }
+};
+
+#endif // BITCOIN_FLATMAP_H
@@ -30,6 +30,7 @@
 #include "rpc/pbaasrpc.h"
 #include "rpc/register.h"
 #include "script/standard.h"
+#include "script/serverchecker.h"
 #include "script/sigcache.h"
 #include "scheduler.h"
 #include "txdb.h"
@@ -353,6 +354,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-?", _("This help message"));
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt("-blockcachesize=<n>", strprintf(_("Keep up to <n> megabytes of recently read blocks in memory (default: %u)"), DEFAULT_BLOCK_CACHE_SIZE));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     strUsage += HelpMessageOpt("-bootstrap", _("Removes previous chain data (if present), downloads and extracts the bootstrap archive."));
     strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), 288));
@@ -368,6 +370,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
     strUsage += HelpMessageOpt("-exportdir=<dir>", _("Specify directory to be used when exporting data"));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
+    strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-mempooltxinputlimit=<n>", _("[DEPRECATED FROM OVERWINTER] Set the maximum number of transparent inputs in a transaction that the mempool will accept (default: 0 = no limit applied)"));
     strUsage += HelpMessageOpt("-notarydatadir=<dir>", _("Specify data directory for notary chain"));
@@ -385,6 +388,8 @@ std::string HelpMessage(HelpMessageMode mode)
 #endif
     strUsage += HelpMessageGroup(_("Index options:"));
     strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
+    strUsage += HelpMessageOpt("-currencystateindex", strprintf(_("Maintain an index of currency states by height, used for historical currency state queries (default: %u)"), 0));
+    strUsage += HelpMessageOpt("-balanceindex", strprintf(_("Maintain the current balance of each address, used to answer getaddressbalance without reading the address's history (default: %u)"), 0));
     strUsage += HelpMessageOpt("-idindex", strprintf(_("Maintain a full identity index, enabling queries to select IDs with addresses, revocation or recovery IDs (default: %u)"), 0));
     strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
     if (showDebug)  
@@ -473,6 +478,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubblocktemplate=<address>", _("Enable publish raw getblocktemplate block in <address>"));
 #endif
 
 #if ENABLE_PROTON
@@ -509,6 +515,8 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", 0));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxsaplingcachesize=<n>", strprintf("Limit size of the verified Sapling proof cache to <n> MiB (default: %u)", DEFAULT_MAX_SAPLING_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxcccachesize=<n>", strprintf("Limit size of the verified crypto-condition cache to <n> MiB (default: %u)", DEFAULT_MAX_CC_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/kB) smaller than this are considered zero fee for relaying (default: %s)"),
@@ -1428,7 +1436,10 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
+        {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadTxPrecomputeCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1758,6 +1769,13 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
 
+    int64_t nBlockCache = std::max(GetArg("-blockcachesize", DEFAULT_BLOCK_CACHE_SIZE), (int64_t)0) << 20;
+    InitBlockCache(nBlockCache);
+    if (nBlockCache)
+    {
+        LogPrintf("* Using %.1fMiB for recently read blocks\n", nBlockCache * (1.0 / 1024 / 1024));
+    }
+
     if ( fReindex == 0 )
     {
         bool checkval,fAddressIndex,fSpentIndex,fTimeStampIndex;
@@ -1790,6 +1808,24 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
             fReindex = true;
         }
 
+        pblocktree->ReadFlag("currencystateindex", checkval);
+        fCurrencyStateIndex = GetBoolArg("-currencystateindex", checkval);
+        if ( checkval != fCurrencyStateIndex )
+        {
+            pblocktree->WriteFlag("currencystateindex", fCurrencyStateIndex);
+            fprintf(stderr,"set currencystateindex, will reindex. sorry will take a while.\n");
+            fReindex = true;
+        }
+
+        pblocktree->ReadFlag("balanceindex", checkval);
+        fBalanceIndex = GetBoolArg("-balanceindex", checkval);
+        if ( checkval != fBalanceIndex )
+        {
+            pblocktree->WriteFlag("balanceindex", fBalanceIndex);
+            fprintf(stderr,"set balanceindex, will reindex. sorry will take a while.\n");
+            fReindex = true;
+        }
+
         /* 
         pblocktree->ReadFlag("conversionindex", checkval);
         fConversionIndex = GetBoolArg("-conversionindex", checkval);
@@ -1823,7 +1859,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     bool clearWitnessCaches = false;
 
     bool fLoaded = false;
-    while (!fLoaded) {
+    while (!fLoaded && !fRequestShutdown) {
         bool fReset = fReindex;
         std::string strLoadError;
 
@@ -1848,11 +1884,28 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
                 if (fReindex) {
                     pblocktree->WriteReindexing(true);
+                    // rebuilt address and transaction indexes record their blocks from the start
+                    pblocktree->WriteFlag("addressunspentblocks", true);
+                    pblocktree->WriteFlag("txindexblocks", true);
                     //If we're reindexing in prune mode, wipe away unusable block files and all undo data files
                     if (fPruneMode)
                         CleanupBlockRevFiles();
                 }
 
+                if (!pcoinsdbview->Upgrade()) {
+                    strLoadError = _("Error upgrading chainstate database");
+                    break;
+                }
+                // an interrupted upgrade resumes on the next start
+                if (ShutdownRequested()) {
+                    break;
+                }
+
+                if (!pcoinsdbview->InitStats()) {
+                    strLoadError = _("Error computing UTXO set statistics");
+                    break;
+                }
+
                 if (!LoadBlockIndex()) {
                     strLoadError = _("Error loading block database");
                     break;
@@ -1882,6 +1935,18 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
                     break;
                 }
 
+                pblocktree->ReadFlag("currencystateindex", fCurrencyStateIndex);
+                if (!fReindex && fCurrencyStateIndex != GetBoolArg("-currencystateindex", fCurrencyStateIndex) ) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -currencystateindex");
+                    break;
+                }
+
+                pblocktree->ReadFlag("balanceindex", fBalanceIndex);
+                if (!fReindex && fBalanceIndex != GetBoolArg("-balanceindex", fBalanceIndex) ) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -balanceindex");
+                    break;
+                }
+
                 /*
                 pblocktree->ReadFlag("conversionindex", fConversionIndex);
                 if (!fReindex && fConversionIndex != GetBoolArg("-conversionindex", fConversionIndex) ) {
@@ -1974,7 +2039,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
             fLoaded = true;
         } while(false);
 
-        if (!fLoaded) {
+        if (!fLoaded && !ShutdownRequested()) {
             // first suggest a reindex
             if (!fReset) {
                 bool fRet = uiInterface.ThreadSafeMessageBox(
@@ -2315,6 +2380,22 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     // recently added to the mempool.
     threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "txnotify", &ThreadNotifyRecentlyAdded));
 
+    // address unspent index records from before they included their confirming block are upgraded in the background
+    bool fAddressUnspentBlocks = false;
+    if (fAddressIndex && (!pblocktree->ReadFlag("addressunspentblocks", fAddressUnspentBlocks) || !fAddressUnspentBlocks))
+        threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "addrupgrade", &ThreadUpgradeAddressUnspentIndex));
+
+    // as are transaction index entries from before they included their block hash
+    bool fTxIndexBlocks = false;
+    if (fTxIndex && (!pblocktree->ReadFlag("txindexblocks", fTxIndexBlocks) || !fTxIndexBlocks))
+        threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "txupgrade", &ThreadUpgradeTxIndex));
+
+    // the coin supply is stored in the block index for blocks connected from now on, and older blocks are filled in
+    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "supply", &ThreadBackfillCoinSupply));
+
+    // long polls share one template per tip, which is built as soon as the tip changes and may be published
+    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "templates", &ThreadBlockTemplates));
+
     if (GetBoolArg("-listenonion", DEFAULT_LISTEN_ONION))
         StartTorControl(threadGroup, scheduler);
 
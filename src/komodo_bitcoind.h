@@ -1544,7 +1544,7 @@ int32_t komodo_checkPOW(int32_t slowflag,CBlock *pblock,int32_t height)
 
 bool IsCoinbaseTimeLocked(const CTransaction &tx, uint32_t &outUnlockHeight);
 
-void GetImmatureCoins(std::map<uint32_t, int64_t> *pimmatureBlockAmounts, CBlock &block, uint32_t &maturity, int64_t &amount, uint32_t height)
+void GetImmatureCoins(std::map<uint32_t, int64_t> *pimmatureBlockAmounts, const CBlock &block, uint32_t &maturity, int64_t &amount, uint32_t height)
 {
     std::map<uint32_t, int64_t> _unlockBlockAmounts;
     std::map<uint32_t, int64_t> &unlockBlockAmounts = pimmatureBlockAmounts ? *pimmatureBlockAmounts : _unlockBlockAmounts;
@@ -1714,12 +1714,30 @@ int64_t komodo_coinsupply(int64_t *zfundsp,int32_t height)
     return(supply);
 }
 
-bool GetCoinSupply(int64_t &transparentSupply, int64_t *pzsupply, int64_t *pimmaturesupply, uint32_t height)
+bool GetCoinSupply(int64_t &transparentSupply, int64_t *pzsupply, int64_t *pimmaturesupply, uint32_t height, CCurrencyValueMap *pcurrencysupply)
 {
     int64_t _immature = 0, _zsupply = 0;
     int64_t &immature = pimmaturesupply ? *pimmaturesupply : _immature;
     int64_t &zfunds = pzsupply ? *pzsupply : _zsupply;
 
+    {
+        LOCK(cs_main);
+        CBlockIndex *pIndex = chainActive[std::min((int)height, chainActive.Height())];
+        if (pIndex && (pIndex->nStatus & BLOCK_HAVE_SUPPLY))
+        {
+            transparentSupply += pIndex->nChainTransparentSupply;
+            zfunds += pIndex->nChainShieldedSupply;
+            immature += pIndex->nChainImmatureSupply;
+            if (pcurrencysupply && pIndex->pChainCurrencySupply)
+            {
+                *pcurrencysupply += *pIndex->pChainCurrencySupply;
+            }
+            return true;
+        }
+    }
+
+    // blocks that the background job has not reached yet are read to find the supply
+
     // keep a running map of immature coin amounts and block maturity as we move forward on the block chain
     std::map<uint32_t, int64_t> immatureBlockAmounts;
 
@@ -1735,7 +1753,7 @@ bool GetCoinSupply(int64_t &transparentSupply, int64_t *pzsupply, int64_t *pimma
         LOCK(cs_main);
         if ( (pIndex = komodo_chainactive(curHeight)) != 0 )
         {
-            if ( pIndex->newcoins == 0 && pIndex->zfunds == 0 )
+            if ( !(pIndex->nStatus & BLOCK_HAVE_SUPPLY) && pIndex->newcoins == 0 && pIndex->zfunds == 0 )
             {
                 if ( komodo_blockload(block, pIndex) != 0 || !GetNewCoins(pIndex->newcoins, &pIndex->zfunds, &immatureBlockAmounts, block, pIndex->maturity, pIndex->immature, curHeight) )
                 {
@@ -27,11 +27,21 @@ SOFTWARE.
 #ifndef LRUCACHE_H
 #define LRUCACHE_H
 
+#include <atomic>
 #include <iterator>
 #include <list>
 #include <map>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "crypto/common.h"
+#include "serialize.h"
 #include "sync.h"
+#include "uint256.h"
 #include "util.h"
 
 template <typename TKey, typename TValue>
@@ -233,4 +243,277 @@ private:
     }
 };
 
+// hashes the key types of CShardedLRUCache, which are mostly hashes or tuples of them
+struct CLRUKeyHasher
+{
+    template <unsigned int BITS>
+    size_t operator()(const base_blob<BITS> &key) const
+    {
+        static_assert(BITS >= 64, "keys must have at least 64 bits");
+        return Mix(ReadLE64(key.begin()));
+    }
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, int>::type = 0>
+    size_t operator()(const T &key) const
+    {
+        return Mix((uint64_t)key);
+    }
+
+    template <typename T1, typename T2>
+    size_t operator()(const std::pair<T1, T2> &key) const
+    {
+        return Combine((*this)(key.first), (*this)(key.second));
+    }
+
+    template <typename... T>
+    size_t operator()(const std::tuple<T...> &key) const
+    {
+        size_t hash = 0;
+        std::apply([this, &hash](const T &... elements) { ((hash = Combine(hash, (*this)(elements))), ...); }, key);
+        return hash;
+    }
+
+private:
+    static size_t Mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        return (size_t)value;
+    }
+
+    static size_t Combine(size_t seed, size_t hash)
+    {
+        return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+};
+
+template <typename T, typename = void>
+struct CLRUIsSerializable : std::false_type {};
+
+template <typename T>
+struct CLRUIsSerializable<T, std::void_t<decltype(std::declval<const T &>().Serialize(std::declval<CSizeComputer &>()))>> : std::true_type {};
+
+// approximate memory used by a cached key or value: the serialized size of objects that have one, which tracks their
+// variable length contents, and the in memory size of everything else
+template <typename T>
+size_t LRUCacheObjectSize(const T &obj)
+{
+    if constexpr (CLRUIsSerializable<T>::value)
+    {
+        return GetSerializeSize(obj, SER_DISK, 0);
+    }
+    else
+    {
+        return sizeof(T);
+    }
+}
+
+template <typename T1, typename T2>
+size_t LRUCacheObjectSize(const std::pair<T1, T2> &obj)
+{
+    return LRUCacheObjectSize(obj.first) + LRUCacheObjectSize(obj.second);
+}
+
+template <typename... T>
+size_t LRUCacheObjectSize(const std::tuple<T...> &obj)
+{
+    return std::apply([](const T &... elements) { return (size_t(0) + ... + LRUCacheObjectSize(elements)); }, obj);
+}
+
+// shared objects are counted at their full size, since the cache usually holds the only long lived reference
+template <typename T>
+size_t LRUCacheObjectSize(const std::shared_ptr<T> &obj)
+{
+    return obj ? LRUCacheObjectSize(*obj) + sizeof(T) : 0;
+}
+
+template <typename T>
+size_t LRUCacheObjectSize(const std::vector<T> &obj)
+{
+    size_t size = 0;
+    for (auto &oneElement : obj)
+    {
+        size += LRUCacheObjectSize(oneElement);
+    }
+    return size;
+}
+
+/**
+ * An LRU cache that may be used from any thread. Entries are spread over shards by key hash, each with its own lock,
+ * hash map and LRU list, so lookups are O(1) and threads only contend when they touch the same shard. Capacity is in
+ * approximate bytes, divided evenly between shards, and each shard evicts its least recently used entries when full.
+ */
+template <typename TKey, typename TValue, typename THasher=CLRUKeyHasher>
+class CShardedLRUCache {
+public:
+    struct CStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t entries;
+        size_t usedBytes;
+        size_t capacityBytes;
+    };
+
+private:
+    class _LRUEntry {
+    public:
+        _LRUEntry(const TKey &key, const TValue &value, size_t size) : Key(key), Value(value), Size(size) { }
+
+        TKey Key;
+        TValue Value;
+        size_t Size;
+    };
+
+    class _Shard {
+    public:
+        CCriticalSection m_shardLock;
+        std::list<_LRUEntry> m_lruList;
+        std::unordered_map<TKey, typename std::list<_LRUEntry>::iterator, THasher> m_lookUpMap;
+        size_t m_usedBytes = 0;
+    };
+
+    // list and hash map nodes for each entry
+    static constexpr const size_t ENTRY_OVERHEAD = 96;
+    static constexpr const unsigned int DEFAULT_SHARDS = 16;
+
+    std::vector<_Shard> m_shards;
+    size_t m_shardCapacity;
+    THasher m_hasher;
+
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+    std::atomic<uint64_t> m_evictions;
+
+    _Shard &GetShard(const TKey &key)
+    {
+        // the low bits also pick the hash map bucket, so shards use the high bits
+        return m_shards[((uint64_t)m_hasher(key) >> 32) % m_shards.size()];
+    }
+
+public:
+    CShardedLRUCache(size_t capacityBytes, unsigned int shards=DEFAULT_SHARDS) :
+        m_shards(shards ? shards : 1), m_shardCapacity(capacityBytes / m_shards.size()), m_hits(0), m_misses(0), m_evictions(0) {}
+
+    int count(const TKey &key)
+    {
+        _Shard &shard = GetShard(key);
+        LOCK(shard.m_shardLock);
+        return shard.m_lookUpMap.count(key);
+    }
+
+    bool Get(const TKey &key, TValue &outValue)
+    {
+        _Shard &shard = GetShard(key);
+        LOCK(shard.m_shardLock);
+        auto mapEntry = shard.m_lookUpMap.find(key);
+        if (mapEntry == shard.m_lookUpMap.end())
+        {
+            m_misses++;
+            return false;
+        }
+        auto lruEntry = mapEntry->second;
+        // move the item to front.
+        if (lruEntry != shard.m_lruList.begin())
+        {
+            shard.m_lruList.splice(shard.m_lruList.begin(), shard.m_lruList, lruEntry);
+        }
+        m_hits++;
+        outValue = lruEntry->Value;
+        return true;
+    }
+
+    TValue Get(const TKey &key)
+    {
+        TValue value;
+        if (!Get(key, value))
+        {
+            return TValue();
+        }
+        return value;
+    }
+
+    void Put(const TKey &key, const TValue &value)
+    {
+        size_t entrySize = LRUCacheObjectSize(key) + LRUCacheObjectSize(value) + ENTRY_OVERHEAD;
+        _Shard &shard = GetShard(key);
+        LOCK(shard.m_shardLock);
+        auto mapEntry = shard.m_lookUpMap.find(key);
+        if (mapEntry != shard.m_lookUpMap.end())
+        {
+            auto lruEntry = mapEntry->second;
+            if (lruEntry != shard.m_lruList.begin())
+            {
+                shard.m_lruList.splice(shard.m_lruList.begin(), shard.m_lruList, lruEntry);
+            }
+            shard.m_usedBytes = shard.m_usedBytes - lruEntry->Size + entrySize;
+            lruEntry->Value = value;
+            lruEntry->Size = entrySize;
+        }
+        else
+        {
+            shard.m_lruList.emplace_front(key, value, entrySize);
+            shard.m_lookUpMap[key] = shard.m_lruList.begin();
+            shard.m_usedBytes += entrySize;
+        }
+
+        // always keep the newest entry, even if it is larger than the shard
+        while (shard.m_usedBytes > m_shardCapacity && shard.m_lruList.size() > 1)
+        {
+            _LRUEntry &oldest = shard.m_lruList.back();
+            shard.m_usedBytes -= oldest.Size;
+            shard.m_lookUpMap.erase(oldest.Key);
+            shard.m_lruList.pop_back();
+            m_evictions++;
+        }
+    }
+
+    bool Erase(const TKey &key)
+    {
+        _Shard &shard = GetShard(key);
+        LOCK(shard.m_shardLock);
+        auto mapEntry = shard.m_lookUpMap.find(key);
+        if (mapEntry == shard.m_lookUpMap.end())
+        {
+            return false;
+        }
+        shard.m_usedBytes -= mapEntry->second->Size;
+        shard.m_lruList.erase(mapEntry->second);
+        shard.m_lookUpMap.erase(mapEntry);
+        return true;
+    }
+
+    void Clear()
+    {
+        for (auto &shard : m_shards)
+        {
+            LOCK(shard.m_shardLock);
+            shard.m_lookUpMap.clear();
+            shard.m_lruList.clear();
+            shard.m_usedBytes = 0;
+        }
+        LogPrint("lrucache", "Cache cleared\n");
+    }
+
+    CStats GetStats()
+    {
+        CStats stats;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.entries = 0;
+        stats.usedBytes = 0;
+        stats.capacityBytes = m_shardCapacity * m_shards.size();
+        for (auto &shard : m_shards)
+        {
+            LOCK(shard.m_shardLock);
+            stats.entries += shard.m_lruList.size();
+            stats.usedBytes += shard.m_usedBytes;
+        }
+        return stats;
+    }
+};
+
 #endif // LRUCACHE_H
@@ -20,8 +20,10 @@
 #include "clientversion.h"
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
+#include "crypto/sha256.h"
 #include "deprecation.h"
 #include "init.h"
+#include "memusage.h"
 #include "merkleblock.h"
 #include "metrics.h"
 #include "mmr.h"
@@ -31,7 +33,9 @@
 #include "pbaas/notarization.h"
 #include "pbaas/identity.h"
 #include "pow.h"
+#include "random.h"
 #include "script/interpreter.h"
+#include "script/sigcache.h"
 #include "txdb.h"
 #include "txmempool.h"
 #include "ui_interface.h"
@@ -56,6 +60,13 @@
 #include <boost/math/distributions/poisson.hpp>
 #include <boost/thread.hpp>
 #include <boost/static_assert.hpp>
+#include <boost/unordered_set.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 using namespace std;
 
@@ -88,6 +99,8 @@ bool fImporting = false;
 bool fReindex = false;
 bool fTxIndex = true;
 bool fIdIndex = false;
+bool fCurrencyStateIndex = false;
+bool fBalanceIndex = false;
 bool fConversionIndex = false;      // index conversions by final destination
 bool fInsightExplorer = false;      // this ensures that the primary address and spent indexes are active, enabling advanced CCs
 bool fAddressIndex = true;
@@ -194,6 +207,10 @@ namespace {
      */
     multimap<CBlockIndex*, CBlockIndex*> mapBlocksUnlinked;
 
+    /** Blocks with a stored supply whose coinbase is time locked past COINBASE_MATURITY, by the height that it
+     *  matures at. Entries may be on any branch. */
+    multimap<uint32_t, CBlockIndex*> mapTimeLockedSupply;
+
     CCriticalSection cs_LastBlockFile;
     std::vector<CBlockFileInfo> vinfoBlockFile;
     int nLastBlockFile = 0;
@@ -1217,6 +1234,228 @@ bool ContextualCheckCoinbaseTransaction(const CTransaction &tx, uint32_t nHeight
     return valid;
 }
 
+/**
+ * Cache of transactions whose Sapling spend, output and binding signature checks have passed,
+ * so that proofs verified on mempool entry or by the parallel pre-pass in ConnectBlock are not
+ * verified again. Entries are SHA256(nonce || txid || sighash), as the txid commits to all shielded
+ * data and the sighash commits to the consensus branch.
+ */
+class CSaplingProofCache
+{
+private:
+    // entries are already salted, so no extra blinding is needed in the set hash
+    struct CSaplingProofCacheHasher
+    {
+        size_t operator()(const uint256& key) const {
+            return key.GetCheapHash();
+        }
+    };
+
+    uint256 nonce;
+    typedef boost::unordered_set<uint256, CSaplingProofCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_saplingcache;
+
+    uint256 ComputeEntry(const uint256 &txid, const uint256 &dataToBeSigned)
+    {
+        uint256 entry;
+        CSHA256().Write(nonce.begin(), 32).Write(txid.begin(), 32).Write(dataToBeSigned.begin(), 32).Finalize(entry.begin());
+        return entry;
+    }
+
+public:
+    CSaplingProofCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    bool Get(const uint256 &txid, const uint256 &dataToBeSigned)
+    {
+        uint256 entry = ComputeEntry(txid, dataToBeSigned);
+        boost::shared_lock<boost::shared_mutex> lock(cs_saplingcache);
+        return setValid.count(entry);
+    }
+
+    void Set(const uint256 &txid, const uint256 &dataToBeSigned)
+    {
+        size_t nMaxCacheSize = GetArg("-maxsaplingcachesize", DEFAULT_MAX_SAPLING_CACHE_SIZE) * ((size_t) 1 << 20);
+        if (nMaxCacheSize <= 0) return;
+
+        uint256 entry = ComputeEntry(txid, dataToBeSigned);
+        boost::unique_lock<boost::shared_mutex> lock(cs_saplingcache);
+        while (memusage::DynamicUsage(setValid) > nMaxCacheSize)
+        {
+            map_type::size_type s = GetRand(setValid.bucket_count());
+            map_type::local_iterator it = setValid.begin(s);
+            if (it != setValid.end(s)) {
+                setValid.erase(*it);
+            }
+        }
+        setValid.insert(entry);
+    }
+};
+
+static CSaplingProofCache saplingProofCache;
+
+/**
+ * Computes the hash that JoinSplit and Sapling signatures of a shielded transaction are bound to. Returns
+ * true with a null hash for transactions that have no shielded components.
+ */
+static bool GetShieldedDataToBeSigned(const CTransaction &tx, const CChainParams &chainparams, int nHeight, uint256 &dataToBeSigned)
+{
+    dataToBeSigned = uint256();
+
+    if (!tx.IsMint() &&
+        (!tx.vJoinSplit.empty() ||
+         !tx.vShieldedSpend.empty() ||
+         !tx.vShieldedOutput.empty()))
+    {
+        bool isVerusVault = CVerusSolutionVector::GetVersionByHeight(nHeight) >= CActivationHeight::ACTIVATE_VERUSVAULT;
+        auto consensusBranchId = CurrentEpochBranchId(nHeight, chainparams.GetConsensus());
+        // Empty output script.
+        CScript scriptCode;
+        bool sigHashSingle = false;
+
+        if (isVerusVault && tx.vJoinSplit.empty() && tx.vShieldedSpend.empty() && !tx.vShieldedOutput.empty() && tx.vin.size() > 0)
+        {
+            // if vin[0] is a smart signature for SIGHASH_SINGLE | SIGHASH_ANYONECANPAY, and the tx has no shielded spends,
+            // but does have shielded outputs, the transaction binding signature is only bound to the transparent input,
+            // all z-outputs, and no z-inputs. if there are shielded inputs, we do not afford the transaction this exception
+            CSmartTransactionSignatures smartSigs;
+            std::vector<unsigned char> ffVec = GetFulfillmentVector(tx.vin[0].scriptSig);
+            if (ffVec.size() && (smartSigs = CSmartTransactionSignatures(std::vector<unsigned char>(ffVec.begin(), ffVec.end()))).IsValid())
+            {
+                if (smartSigs.sigHashType == (SIGHASH_SINGLE | SIGHASH_ANYONECANPAY))
+                {
+                    sigHashSingle = true;
+                }
+            }
+        }
+        try {
+            if (sigHashSingle == true)
+            {
+                dataToBeSigned = SignatureHash(scriptCode, tx, 0, SIGHASH_SINGLE | SIGHASH_ANYONECANPAY, 0, consensusBranchId);
+            }
+            else
+            {
+                dataToBeSigned = SignatureHash(scriptCode, tx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId);
+            }
+        } catch (std::logic_error ex) {
+            return false;
+        }
+    }
+    return true;
+}
+
+enum ESaplingCheckResult
+{
+    SAPLING_CHECK_OK = 0,
+    SAPLING_CHECK_BAD_SPEND = 1,
+    SAPLING_CHECK_BAD_OUTPUT = 2,
+    SAPLING_CHECK_BAD_BINDING_SIG = 3
+};
+
+/**
+ * Verifies all Sapling spend and output proofs and the binding signature of a transaction with a single
+ * verification context.
+ */
+static ESaplingCheckResult CheckSaplingDescriptions(const CTransaction &tx, const uint256 &dataToBeSigned)
+{
+    auto ctx = librustzcash_sapling_verification_ctx_init();
+
+    for (const SpendDescription &spend : tx.vShieldedSpend) {
+        if (!librustzcash_sapling_check_spend(
+            ctx,
+            spend.cv.begin(),
+            spend.anchor.begin(),
+            spend.nullifier.begin(),
+            spend.rk.begin(),
+            spend.zkproof.begin(),
+            spend.spendAuthSig.begin(),
+            dataToBeSigned.begin()
+        ))
+        {
+            librustzcash_sapling_verification_ctx_free(ctx);
+            return SAPLING_CHECK_BAD_SPEND;
+        }
+    }
+
+    for (const OutputDescription &output : tx.vShieldedOutput) {
+        if (!librustzcash_sapling_check_output(
+            ctx,
+            output.cv.begin(),
+            output.cm.begin(),
+            output.ephemeralKey.begin(),
+            output.zkproof.begin()
+        ))
+        {
+            librustzcash_sapling_verification_ctx_free(ctx);
+            return SAPLING_CHECK_BAD_OUTPUT;
+        }
+    }
+
+    if (!librustzcash_sapling_final_check(
+        ctx,
+        tx.valueBalance,
+        tx.bindingSig.begin(),
+        dataToBeSigned.begin()
+    ))
+    {
+        librustzcash_sapling_verification_ctx_free(ctx);
+        return SAPLING_CHECK_BAD_BINDING_SIG;
+    }
+
+    librustzcash_sapling_verification_ctx_free(ctx);
+    return SAPLING_CHECK_OK;
+}
+
+// parses every output of a transaction as a crypto-condition and decodes the objects that the smart transaction
+// prechecks and CReserveTransactionDescriptor read through its output descriptors. this only depends on the
+// transaction, and the results are cached on it for the ordered pass.
+static void PrecomputeOutputDescriptors(const CTransaction &tx)
+{
+    for (int i = 0; i < tx.vout.size(); i++)
+    {
+        const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(i);
+        if (!outDesc.isPayToCC || !outDesc.p.IsValid())
+        {
+            continue;
+        }
+        switch (outDesc.p.evalCode)
+        {
+            case EVAL_RESERVE_DEPOSIT:
+                outDesc.GetObject<CReserveDeposit>();
+                break;
+            case EVAL_RESERVE_OUTPUT:
+                outDesc.GetObject<CTokenOutput>();
+                break;
+            case EVAL_RESERVE_TRANSFER:
+                outDesc.GetObject<CReserveTransfer>();
+                break;
+            case EVAL_CURRENCY_DEFINITION:
+                outDesc.GetObject<CCurrencyDefinition>();
+                break;
+        }
+    }
+}
+
+bool CTxPrecomputeCheck::operator()()
+{
+    *txdata = PrecomputedTransactionData(*ptxTo);
+    PrecomputeOutputDescriptors(*ptxTo);
+
+    uint256 dataToBeSigned;
+    if (fCheckSapling &&
+        (!ptxTo->vShieldedSpend.empty() || !ptxTo->vShieldedOutput.empty()) &&
+        GetShieldedDataToBeSigned(*ptxTo, *chainparams, nHeight, dataToBeSigned) &&
+        !saplingProofCache.Get(ptxTo->GetHash(), dataToBeSigned) &&
+        CheckSaplingDescriptions(*ptxTo, dataToBeSigned) == SAPLING_CHECK_OK)
+    {
+        saplingProofCache.Set(ptxTo->GetHash(), dataToBeSigned);
+    }
+    return true;
+}
+
 /**
  * Check a transaction contextually against a set of consensus rules valid at a given block height.
  *
@@ -1239,7 +1478,6 @@ bool ContextualCheckTransaction(
     bool isSprout = !overwinterActive;
 
     uint32_t verusVersion = CVerusSolutionVector::GetVersionByHeight(nHeight);
-    bool isVerusVault = verusVersion >= CActivationHeight::ACTIVATE_VERUSVAULT;
     bool isPBaaS = verusVersion >= CActivationHeight::ACTIVATE_PBAAS;
 
     // If Sprout rules apply, reject transactions which are intended for Overwinter and beyond
@@ -1332,44 +1570,10 @@ bool ContextualCheckTransaction(
 
     uint256 dataToBeSigned;
 
-    if (!tx.IsMint() &&
-        (!tx.vJoinSplit.empty() ||
-         !tx.vShieldedSpend.empty() ||
-         !tx.vShieldedOutput.empty()))
+    if (!GetShieldedDataToBeSigned(tx, chainparams, nHeight, dataToBeSigned))
     {
-        auto consensusBranchId = CurrentEpochBranchId(nHeight, chainparams.GetConsensus());
-        // Empty output script.
-        CScript scriptCode;
-        bool sigHashSingle = false;
-
-        if (isVerusVault && tx.vJoinSplit.empty() && tx.vShieldedSpend.empty() && !tx.vShieldedOutput.empty() && tx.vin.size() > 0)
-        {
-            // if vin[0] is a smart signature for SIGHASH_SINGLE | SIGHASH_ANYONECANPAY, and the tx has no shielded spends,
-            // but does have shielded outputs, the transaction binding signature is only bound to the transparent input,
-            // all z-outputs, and no z-inputs. if there are shielded inputs, we do not afford the transaction this exception
-            CSmartTransactionSignatures smartSigs;
-            std::vector<unsigned char> ffVec = GetFulfillmentVector(tx.vin[0].scriptSig);
-            if (ffVec.size() && (smartSigs = CSmartTransactionSignatures(std::vector<unsigned char>(ffVec.begin(), ffVec.end()))).IsValid())
-            {
-                if (smartSigs.sigHashType == (SIGHASH_SINGLE | SIGHASH_ANYONECANPAY))
-                {
-                    sigHashSingle = true;
-                }
-            }
-        }
-        try {
-            if (sigHashSingle == true)
-            {
-                dataToBeSigned = SignatureHash(scriptCode, tx, 0, SIGHASH_SINGLE | SIGHASH_ANYONECANPAY, 0, consensusBranchId);
-            }
-            else
-            {
-                dataToBeSigned = SignatureHash(scriptCode, tx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId);
-            }
-        } catch (std::logic_error ex) {
-            return state.DoS(100, error("CheckTransaction(): error computing signature hash"),
-                             REJECT_INVALID, "error-computing-signature-hash");
-        }
+        return state.DoS(100, error("CheckTransaction(): error computing signature hash"),
+                            REJECT_INVALID, "error-computing-signature-hash");
     }
 
     if (!(tx.IsMint() || tx.vJoinSplit.empty()))
@@ -1406,61 +1610,32 @@ bool ContextualCheckTransaction(
     if (!tx.vShieldedSpend.empty() ||
         !tx.vShieldedOutput.empty())
     {
-        auto ctx = librustzcash_sapling_verification_ctx_init();
-
-        for (const SpendDescription &spend : tx.vShieldedSpend) {
-            if (!librustzcash_sapling_check_spend(
-                ctx,
-                spend.cv.begin(),
-                spend.anchor.begin(),
-                spend.nullifier.begin(),
-                spend.rk.begin(),
-                spend.zkproof.begin(),
-                spend.spendAuthSig.begin(),
-                dataToBeSigned.begin()
-            ))
-            {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                return state.DoS(100, error("ContextualCheckTransaction(): Sapling spend description invalid"),
-                                      REJECT_INVALID, "bad-txns-sapling-spend-description-invalid");
-            }
-        }
-
-        for (const OutputDescription &output : tx.vShieldedOutput) {
-            if (!librustzcash_sapling_check_output(
-                ctx,
-                output.cv.begin(),
-                output.cm.begin(),
-                output.ephemeralKey.begin(),
-                output.zkproof.begin()
-            ))
+        if (!saplingProofCache.Get(tx.GetHash(), dataToBeSigned))
+        {
+            switch (CheckSaplingDescriptions(tx, dataToBeSigned))
             {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                return state.DoS(100, error("ContextualCheckTransaction(): Sapling output description invalid"),
-                                      REJECT_INVALID, "bad-txns-sapling-output-description-invalid");
+                case SAPLING_CHECK_BAD_SPEND:
+                    return state.DoS(100, error("ContextualCheckTransaction(): Sapling spend description invalid"),
+                                          REJECT_INVALID, "bad-txns-sapling-spend-description-invalid");
+                case SAPLING_CHECK_BAD_OUTPUT:
+                    return state.DoS(100, error("ContextualCheckTransaction(): Sapling output description invalid"),
+                                          REJECT_INVALID, "bad-txns-sapling-output-description-invalid");
+                case SAPLING_CHECK_BAD_BINDING_SIG:
+                    return state.DoS(100, error("ContextualCheckTransaction(): Sapling binding signature invalid"),
+                                          REJECT_INVALID, "bad-txns-sapling-binding-signature-invalid");
+                case SAPLING_CHECK_OK:
+                    break;
             }
+            saplingProofCache.Set(tx.GetHash(), dataToBeSigned);
         }
-
-        if (!librustzcash_sapling_final_check(
-            ctx,
-            tx.valueBalance,
-            tx.bindingSig.begin(),
-            dataToBeSigned.begin()
-        ))
-        {
-            librustzcash_sapling_verification_ctx_free(ctx);
-            return state.DoS(100, error("ContextualCheckTransaction(): Sapling binding signature invalid"),
-                                  REJECT_INVALID, "bad-txns-sapling-binding-signature-invalid");
-        }
-
-        librustzcash_sapling_verification_ctx_free(ctx);
     }
 
     // precheck all crypto conditions
     for (int i = 0; i < tx.vout.size(); i++)
     {
-        COptCCParams p;
-        if (tx.vout[i].scriptPubKey.IsPayToCryptoCondition(p))
+        const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(i);
+        const COptCCParams &p = outDesc.p;
+        if (outDesc.isPayToCC)
         {
             if (!p.IsValid(isPBaaS, nHeight) && isPBaaS)
             {
@@ -2162,16 +2337,16 @@ bool AcceptToMemoryPoolInt(CTxMemPool& pool, CValidationState &state, const CTra
         if (txDesc.IsReserveTransfer() && !txDesc.IsImport())
         {
             // don't enter reserve transfers that we can reject (fLimitFree is true && not import, so not checking a block) that export to a destination of this chain
-            for (auto &oneOut : tx.vout)
+            for (int j = 0; j < tx.vout.size(); j++)
             {
-                COptCCParams p;
-                CReserveTransfer rt;
-                if (oneOut.scriptPubKey.IsPayToCryptoCondition(p) &&
-                    p.IsValid() &&
-                    p.evalCode == EVAL_RESERVE_TRANSFER &&
-                    p.vData.size() &&
-                    (rt = CReserveTransfer(p.vData[0])).IsValid() &&
-                    rt.GetImportCurrency() == ASSETCHAINS_CHAINID)
+                const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(j);
+                std::shared_ptr<const CReserveTransfer> rt;
+                if (outDesc.isPayToCC &&
+                    outDesc.p.IsValid() &&
+                    outDesc.p.evalCode == EVAL_RESERVE_TRANSFER &&
+                    (rt = outDesc.GetObject<CReserveTransfer>()) &&
+                    rt->IsValid() &&
+                    rt->GetImportCurrency() == ASSETCHAINS_CHAINID)
                 {
                     LogPrintf("AcceptToMemoryPool: invalid reserve transfer transaction, cannot export to current chain :\n%s\n", txDesc.ToUniValue().write(1,2).c_str());
                     return state.DoS(0, error("AcceptToMemoryPool: invalid reserve transfer transaction, cannot export to current chain %s", hash.ToString()), REJECT_NONSTANDARD, "bad-txns-invalid-reservetransfer");
@@ -2318,6 +2493,29 @@ bool AcceptToMemoryPoolInt(CTxMemPool& pool, CValidationState &state, const CTra
                 return false;
             }
 
+            // once the mempool has been trimmed, require the rolling minimum fee rate, normalizing reserve fees to
+            // native, so a spammer cannot keep the pool full without outbidding what was evicted
+            CAmount mempoolRejectFee = (txDesc.IsValid() && (txDesc.IsImport() || txDesc.IsExport() || txDesc.IsNotaryPrioritized())) ?
+                                       0 :
+                                       pool.GetMinFee(GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFee(nSize);
+            if (mempoolRejectFee > 0)
+            {
+                CAmount normalizedFees = nFees;
+                if (txDesc.IsValid() && txDesc.IsReserve())
+                {
+                    CCurrencyState feeConversionState = ConnectedChains.GetCurrencyState(chainActive.Height(), false);
+                    if (feeConversionState.IsValid())
+                    {
+                        normalizedFees = std::max(nFees, txDesc.AllFeesAsNative(feeConversionState));
+                    }
+                }
+                if (normalizedFees < mempoolRejectFee)
+                {
+                    LogPrint("mempool", "%s: fee %d below mempool minimum %d\n", hash.ToString(), normalizedFees, mempoolRejectFee);
+                    return state.DoS(0, false, REJECT_INSUFFICIENTFEE, "mempool min fee not met");
+                }
+            }
+
             if (GetBoolArg("-relaypriority", false) &&
                 nFees < minFee &&
                 !AllowFree(view.GetPriority(tx, chainActive.Height() + 1)))
@@ -2431,6 +2629,20 @@ bool AcceptToMemoryPoolInt(CTxMemPool& pool, CValidationState &state, const CTra
             mempool.PrioritiseReserveTransaction(txDesc);
         }
 
+        // trim the mempool and check if the transaction was among those evicted
+        if (fLimitFree)
+        {
+            size_t mempoolLimit = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+            if (pool.DynamicMemoryUsage() > mempoolLimit)
+            {
+                pool.TrimToSize(mempoolLimit, ConnectedChains.GetCurrencyState(chainActive.Height(), false));
+                if (!pool.exists(hash))
+                {
+                    return state.DoS(0, false, REJECT_INSUFFICIENTFEE, "mempool full");
+                }
+            }
+        }
+
         if (!tx.IsCoinImport())
         {
             // Add memory address index
@@ -2489,6 +2701,36 @@ bool GetAddressIndex(const uint160& addressHash, int type,
     return true;
 }
 
+bool GetAddressIndexReverse(const uint160& addressHash, int type,
+                            const boost::function<bool(const CAddressIndexDbEntry &)> &visit,
+                            int start, int end)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndexReverse(addressHash, type, visit, start, end))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetLatestAddressIndex(const uint160& addressHash, int type,
+                           std::vector<CAddressIndexDbEntry>& addressIndex,
+                           size_t maxEntries, int start, int end)
+{
+    size_t firstNew = addressIndex.size();
+    if (maxEntries &&
+        !GetAddressIndexReverse(addressHash, type, [&addressIndex, firstNew, maxEntries](const CAddressIndexDbEntry &entry) {
+            addressIndex.push_back(entry);
+            return addressIndex.size() - firstNew < maxEntries;
+        }, start, end))
+    {
+        return false;
+    }
+    std::reverse(addressIndex.begin() + firstNew, addressIndex.end());
+    return true;
+}
+
 bool GetAddressUnspent(const uint160& addressHash, int type,
                        std::vector<CAddressUnspentDbEntry>& unspentOutputs)
 {
@@ -2501,6 +2743,44 @@ bool GetAddressUnspent(const uint160& addressHash, int type,
     return true;
 }
 
+bool GetAddressBalance(const uint160& addressHash, int type, CAddressBalanceValue &balance)
+{
+    if (!fBalanceIndex)
+        return error("balance index not enabled");
+
+    if (!pblocktree->ReadAddressBalance(CAddressBalanceKey(type, addressHash), balance))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
+bool GetAddressIndexPage(const uint160& addressHash, int type,
+                         const CAddressIndexKey *after, size_t maxEntries,
+                         std::vector<CAddressIndexDbEntry>& addressIndex,
+                         int start, int end)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndexPage(addressHash, type, after, maxEntries, addressIndex, start, end))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressUnspentPage(const uint160& addressHash, int type,
+                           const CAddressUnspentKey *after, size_t maxEntries,
+                           std::vector<CAddressUnspentDbEntry>& unspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndexPage(addressHash, type, after, maxEntries, unspentOutputs))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
 bool myAddtomempool(CTransaction &tx, CValidationState *pstate, int32_t simHeight, bool limitFree, bool fLimitDust, bool *missinginputs)
 {
     CValidationState state;
@@ -2518,6 +2798,82 @@ void myRemovefrommempool(const CTransaction &tx)
     mempool.remove(tx, removed, true);
 }
 
+static CTransactionCache transactionCache(TX_CACHE_SIZE);
+// erases and inserts of read results are serialized on this lock, and each erase starts a new generation. a read that
+// overlaps an erase may have found the index entry the erase is for, so it returns its result without caching it.
+static CCriticalSection cs_transactionCache;
+static uint64_t nTransactionCacheGeneration = 0;
+
+bool GetBlockTransaction(const uint256 &hash, std::shared_ptr<const CTransaction> &ptx, uint256 &hashBlock)
+{
+    std::pair<std::shared_ptr<const CTransaction>, uint256> cached;
+    if (transactionCache.Get(hash, cached))
+    {
+        ptx = cached.first;
+        hashBlock = cached.second;
+        return true;
+    }
+
+    uint64_t nGeneration;
+    {
+        LOCK(cs_transactionCache);
+        nGeneration = nTransactionCacheGeneration;
+    }
+
+    CDiskTxPos postx;
+    if (!fTxIndex || !pblocktree->ReadTxIndex(hash, postx))
+    {
+        return false;
+    }
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull())
+        return error("%s: OpenBlockFile failed", __func__);
+    CBlockHeader header;
+    std::shared_ptr<CTransaction> pReadTx = std::make_shared<CTransaction>();
+    try {
+        file >> header;
+        fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+        file >> *pReadTx;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    if (pReadTx->GetHash() != hash)
+    {
+        if (LogAcceptCategory("notarization"))
+        {
+            CHashWriter hw(SER_GETHASH, PROTOCOL_VERSION);
+            hw << *pReadTx;
+            LogPrintf("%s: txid mismatch, read: %s, expected: %s, CHashWriter hash: %s\n", __func__, pReadTx->GetHash().GetHex().c_str(), hash.GetHex().c_str(), hw.GetHash().GetHex().c_str());
+        }
+        return error("%s: txid mismatch", __func__);
+    }
+    ptx = pReadTx;
+    hashBlock = postx.blockHash.IsNull() ? header.GetHash() : postx.blockHash;
+    {
+        LOCK(cs_transactionCache);
+        if (nGeneration == nTransactionCacheGeneration)
+        {
+            transactionCache.Put(hash, std::make_pair(ptx, hashBlock));
+        }
+    }
+    return true;
+}
+
+void EraseCachedTransactions(const CBlock &block)
+{
+    LOCK(cs_transactionCache);
+    nTransactionCacheGeneration++;
+    for (auto &tx : block.vtx)
+    {
+        transactionCache.Erase(tx.GetHash());
+    }
+}
+
+CTransactionCache::CStats GetTransactionCacheStats()
+{
+    return transactionCache.GetStats();
+}
+
 bool myGetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock, bool checkMempool)
 {
     // need a GetTransaction without lock so the validation code for assets can run without deadlock
@@ -2532,37 +2888,11 @@ bool myGetTransaction(const uint256 &hash, CTransaction &txOut, uint256 &hashBlo
     }
     //fprintf(stderr,"check disk\n");
 
-    if (fTxIndex) {
-        CDiskTxPos postx;
-        //fprintf(stderr,"ReadTxIndex\n");
-        if (pblocktree->ReadTxIndex(hash, postx)) {
-            //fprintf(stderr,"OpenBlockFile\n");
-            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-            if (file.IsNull())
-                return error("%s: OpenBlockFile failed", __func__);
-            CBlockHeader header;
-            //fprintf(stderr,"seek and read\n");
-            try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txOut;
-            } catch (const std::exception& e) {
-                return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            }
-            hashBlock = header.GetHash();
-            if (txOut.GetHash() != hash)
-            {
-                if (LogAcceptCategory("notarization"))
-                {
-                    CHashWriter hw(SER_GETHASH, PROTOCOL_VERSION);
-                    hw << txOut;
-                    LogPrintf("%s: txid mismatch, read: %s, expected: %s, CHashWriter hash: %s\n", __func__, txOut.GetHash().GetHex().c_str(), hash.GetHex().c_str(), hw.GetHash().GetHex().c_str());
-                }
-                return error("%s: txid mismatch", __func__);
-            }
-            //fprintf(stderr,"found on disk\n");
-            return true;
-        }
+    std::shared_ptr<const CTransaction> ptx;
+    if (GetBlockTransaction(hash, ptx, hashBlock))
+    {
+        txOut = *ptx;
+        return true;
     }
     //fprintf(stderr,"not found\n");
     return false;
@@ -2580,25 +2910,11 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::P
         return true;
     }
 
-    if (fTxIndex) {
-        CDiskTxPos postx;
-        if (pblocktree->ReadTxIndex(hash, postx)) {
-            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-            if (file.IsNull())
-                return error("%s: OpenBlockFile failed", __func__);
-            CBlockHeader header;
-            try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txOut;
-            } catch (const std::exception& e) {
-                return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            }
-            hashBlock = header.GetHash();
-            if (txOut.GetHash() != hash)
-                return error("%s: txid mismatch", __func__);
-            return true;
-        }
+    std::shared_ptr<const CTransaction> ptx;
+    if (GetBlockTransaction(hash, ptx, hashBlock))
+    {
+        txOut = *ptx;
+        return true;
     }
 
     if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
@@ -2676,26 +2992,158 @@ bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHea
     return true;
 }
 
+namespace {
+
+/** A block file mapped read only into memory, which is unmapped when the last reader releases it */
+class CMappedBlockFile
+{
+public:
+    const char *data;
+    size_t size;
+
+    CMappedBlockFile(const char *dataIn, size_t sizeIn) : data(dataIn), size(sizeIn) {}
+    ~CMappedBlockFile()
+    {
+#ifndef WIN32
+        munmap((void *)data, size);
+#endif
+    }
+};
+
+/**
+ * Memory maps of block files that are no longer being written, so blocks can be deserialized straight from the page
+ * cache without opening and seeking the file. The file being appended to is still read through OpenBlockFile, and
+ * only files that have been finalized, so that they will not be truncated, are mapped.
+ */
+class CBlockFileMaps
+{
+private:
+    CCriticalSection cs;
+    std::map<int, std::shared_ptr<const CMappedBlockFile>> mappedFiles; // null for files that could not be mapped
+
+public:
+    std::shared_ptr<const CMappedBlockFile> Get(int nFile)
+    {
+#ifdef WIN32
+        return nullptr;
+#else
+        // mapping every block file needs a 64 bit address space
+        if (sizeof(void *) < 8)
+        {
+            return nullptr;
+        }
+
+        // cs_LastBlockFile is taken before cs when files are forgotten, so it is not held here while taking cs
+        int nFirstOpenFile;
+        {
+            LOCK(cs_LastBlockFile);
+            nFirstOpenFile = nLastBlockFile;
+        }
+        if (nFile >= nFirstOpenFile)
+        {
+            return nullptr;
+        }
+
+        LOCK(cs);
+        auto it = mappedFiles.find(nFile);
+        if (it != mappedFiles.end())
+        {
+            return it->second;
+        }
+
+        std::shared_ptr<const CMappedBlockFile> mapped;
+        boost::filesystem::path path = GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk");
+        int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd != -1)
+        {
+            struct stat fileStat;
+            if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+            {
+                void *data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (data != MAP_FAILED)
+                {
+                    mapped = std::make_shared<const CMappedBlockFile>((const char *)data, (size_t)fileStat.st_size);
+                }
+            }
+            close(fd);
+        }
+        if (!mapped)
+        {
+            LogPrint("blockfiles", "%s: unable to map %s, reading it through the file instead\n", __func__, path.string());
+        }
+        mappedFiles[nFile] = mapped;
+        return mapped;
+#endif
+    }
+
+    // readers that still hold a map keep it until they are done
+    void Forget(int nFile)
+    {
+        LOCK(cs);
+        mappedFiles.erase(nFile);
+    }
+
+    void Clear()
+    {
+        LOCK(cs);
+        mappedFiles.clear();
+    }
+};
+
+CBlockFileMaps blockFileMaps;
+
+// recently read blocks by hash, with whether their proof of work was checked when they were read
+typedef CShardedLRUCache<uint256, std::pair<std::shared_ptr<const CBlock>, bool>> CBlockCache;
+std::unique_ptr<CBlockCache> pblockCache;
+
+}
+
+void InitBlockCache(size_t nCacheBytes)
+{
+    if (nCacheBytes)
+    {
+        pblockCache.reset(new CBlockCache(nCacheBytes));
+    }
+    else
+    {
+        pblockCache.reset();
+    }
+}
+
 bool ReadBlockFromDisk(int32_t height, CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, bool checkPOW)
 {
     uint8_t pubkey33[33];
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
+    // Read block, from a memory map of the file if it has one
+    std::shared_ptr<const CMappedBlockFile> mapped = blockFileMaps.Get(pos.nFile);
+    if (mapped && pos.nPos < mapped->size)
     {
-        //fprintf(stderr,"readblockfromdisk err A\n");
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        try {
+            CMemoryReader reader(mapped->data + pos.nPos, mapped->data + mapped->size, SER_DISK, CLIENT_VERSION);
+            reader >> block;
+        }
+        catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+        }
     }
+    else
+    {
+        // Open history file to read
+        CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+        {
+            //fprintf(stderr,"readblockfromdisk err A\n");
+            return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        }
 
-    // Read block
-    try {
-        filein >> block;
-    }
-    catch (const std::exception& e) {
-        fprintf(stderr,"readblockfromdisk err B\n");
-        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        try {
+            filein >> block;
+        }
+        catch (const std::exception& e) {
+            fprintf(stderr,"readblockfromdisk err B\n");
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
     }
     // Check the header
     if ( height != 0 && checkPOW != 0 )
@@ -2722,12 +3170,25 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     if ( pindex == 0 )
         return false;
 
+    // a cached block is only used if it was checked at least as thoroughly as this read requires
+    std::pair<std::shared_ptr<const CBlock>, bool> cached;
+    if (pblockCache && pblockCache->Get(pindex->GetBlockHash(), cached) && (cached.second || !checkPOW))
+    {
+        block = *cached.first;
+        return true;
+    }
+
     if (!ReadBlockFromDisk(pindex->GetHeight(), block, pindex->GetBlockPos(), consensusParams, checkPOW))
         return error("ReadBlockFromDisk: Errors reading block %s", pindex->GetBlockHash().GetHex());
 
     if (block.GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                      pindex->ToString(), pindex->GetBlockPos().ToString());
+
+    if (pblockCache)
+    {
+        pblockCache->Put(pindex->GetBlockHash(), std::make_pair(std::make_shared<const CBlock>(block), checkPOW));
+    }
     return true;
 }
 
@@ -3411,6 +3872,58 @@ namespace {
  * @param out The out point that corresponds to the tx input.
  * @return True on success.
  */
+// only currency outputs carry reserves, and few of the outputs spent in a block do
+static void RecordSpentReserves(std::map<std::pair<unsigned int, size_t>, CCurrencyValueMap> &spentReserves,
+                                unsigned int txIndex, size_t inputIndex, const CTxOut &prevout)
+{
+    if (prevout.scriptPubKey.IsPayToCryptoCondition())
+    {
+        CCurrencyValueMap reserves = prevout.ReserveOutValue();
+        if (reserves.valueMap.size())
+        {
+            spentReserves[std::make_pair(txIndex, inputIndex)] = reserves;
+        }
+    }
+}
+
+// sums the balance changes of a block's address index entries by address. the native amounts are those of the entries,
+// while reserves received come from the block's outputs and reserves spent from spentReserves.
+static void GetAddressBalanceIndexEntries(const CBlock &block,
+                                          const std::vector<CAddressIndexDbEntry> &addressIndex,
+                                          const std::map<std::pair<unsigned int, size_t>, CCurrencyValueMap> &spentReserves,
+                                          std::vector<CAddressBalanceDbEntry> &balanceIndex)
+{
+    std::map<CAddressBalanceKey, CAddressBalanceValue> balances;
+    for (auto &entry : addressIndex)
+    {
+        const CAddressIndexKey &key = entry.first;
+        CAddressBalanceValue &value = balances[CAddressBalanceKey(key.type, key.hashBytes)];
+        value.balance += entry.second;
+        if (entry.second > 0)
+        {
+            value.received += entry.second;
+        }
+        if (key.spending)
+        {
+            auto it = spentReserves.find(std::make_pair(key.txindex, key.index));
+            if (it != spentReserves.end())
+            {
+                value.reserveBalance -= it->second;
+            }
+        }
+        else if (key.txindex < block.vtx.size() && key.index < block.vtx[key.txindex].vout.size())
+        {
+            CCurrencyValueMap reserves = block.vtx[key.txindex].vout[key.index].ReserveOutValue();
+            if (reserves.valueMap.size())
+            {
+                value.reserveBalance += reserves;
+                value.reserveReceived += reserves;
+            }
+        }
+    }
+    balanceIndex.insert(balanceIndex.end(), balances.begin(), balances.end());
+}
+
 static bool ApplyTxInUndo(const CTxInUndo& undo, CCoinsViewCache& view, const COutPoint& out)
 {
     bool fClean = true;
@@ -3482,6 +3995,35 @@ void SetMaxScriptElementSize(uint32_t height)
     }
 }
 
+// the last valid notarization of each currency in the block, which is the one that CPBaaSNotarization::GetLastNotarization
+// would find for the block's height in the address index
+static void GetCurrencyStateIndexEntries(const CBlock &block, int height, std::vector<CCurrencyStateIndexDbEntry> &entries)
+{
+    std::map<uint160, std::vector<unsigned char>> lastNotarizations;
+    for (auto &tx : block.vtx)
+    {
+        for (auto &out : tx.vout)
+        {
+            COptCCParams p;
+            if (out.scriptPubKey.IsPayToCryptoCondition(p) &&
+                p.IsValid() &&
+                (p.evalCode == EVAL_ACCEPTEDNOTARIZATION || p.evalCode == EVAL_EARNEDNOTARIZATION) &&
+                p.vData.size())
+            {
+                CPBaaSNotarization notarization(p.vData[0]);
+                if (notarization.IsValid())
+                {
+                    lastNotarizations[notarization.currencyID] = p.vData[0];
+                }
+            }
+        }
+    }
+    for (auto &oneNotarization : lastNotarizations)
+    {
+        entries.push_back(std::make_pair(CCurrencyStateIndexKey(oneNotarization.first, height), oneNotarization.second));
+    }
+}
+
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state.
  *  The addressIndex and spentIndex will be updated if requested.
@@ -3512,6 +4054,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     std::vector<CAddressIndexDbEntry> addressIndex;
     std::vector<CAddressUnspentDbEntry> addressUnspentIndex;
     std::vector<CSpentIndexDbEntry> spentIndex;
+    std::map<std::pair<unsigned int, size_t>, CCurrencyValueMap> spentReserves;
 
     uint32_t nHeight = pindex->GetHeight();
 
@@ -3633,6 +4176,16 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
                 const CTxIn input = tx.vin[j];
                 if (fAddressIndex && updateIndices) {
                     const CTxOut &prevout = view.GetOutputFor(input);
+                    if (fBalanceIndex) {
+                        RecordSpentReserves(spentReserves, i, j, prevout);
+                    }
+
+                    // undo only records the height of an output that was the last unspent of its transaction, but the
+                    // restored coins always have it
+                    const CCoins *prevCoins = view.AccessCoins(input.prevout.hash);
+                    int prevHeight = prevCoins ? prevCoins->nHeight : undo.nHeight;
+                    const CBlockIndex *pPrevIndex = pindex->GetAncestor(prevHeight);
+                    uint256 prevBlockHash = pPrevIndex ? pPrevIndex->GetBlockHash() : uint256();
 
                     COptCCParams p;
                     if (prevout.scriptPubKey.IsPayToCryptoCondition(p))
@@ -3673,7 +4226,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
                                 // restore unspent index
                                 addressUnspentIndex.push_back(make_pair(
                                     CAddressUnspentKey(AddressTypeFromDest(dest), destID, input.prevout.hash, input.prevout.n),
-                                    CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight)));
+                                    CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight, prevHeight, prevBlockHash)));
                             }
                         }
                     }
@@ -3693,7 +4246,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
                                 // restore unspent index
                                 addressUnspentIndex.push_back(make_pair(
                                     CAddressUnspentKey(scriptType, addrHash, input.prevout.hash, input.prevout.n),
-                                    CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight)));
+                                    CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight, prevHeight, prevBlockHash)));
                             }
                         }
                     }
@@ -3740,6 +4293,25 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
             AbortNode(state, "Failed to write address unspent index");
             return DISCONNECT_FAILED;
         }
+        if (fBalanceIndex) {
+            uint256 hashApplied;
+            int nAppliedHeight;
+            if (!pblocktree->ReadAddressBalanceBlock(hashApplied, nAppliedHeight)) {
+                AbortNode(state, "Failed to read address balance index");
+                return DISCONNECT_FAILED;
+            }
+            // indexes written before the last block was recorded are taken to be at the chain state
+            if (!hashApplied.IsNull() && hashApplied != pindex->GetBlockHash()) {
+                AbortNode(state, "Address balance index does not match the chain, rebuild it with -reindex");
+                return DISCONNECT_FAILED;
+            }
+            std::vector<CAddressBalanceDbEntry> balanceIndex;
+            GetAddressBalanceIndexEntries(block, addressIndex, spentReserves, balanceIndex);
+            if (!pblocktree->UpdateAddressBalanceIndex(balanceIndex, false, pindex->pprev->GetBlockHash(), pindex->GetHeight() - 1)) {
+                AbortNode(state, "Failed to write address balance index");
+                return DISCONNECT_FAILED;
+            }
+        }
     }
     // insightexplorer
     if (fSpentIndex && updateIndices) {
@@ -3748,6 +4320,14 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
             return DISCONNECT_FAILED;
         }
     }
+    if (fCurrencyStateIndex && updateIndices) {
+        std::vector<CCurrencyStateIndexDbEntry> currencyStateIndex;
+        GetCurrencyStateIndexEntries(block, pindex->GetHeight(), currencyStateIndex);
+        if (!pblocktree->EraseCurrencyStateIndex(currencyStateIndex)) {
+            AbortNode(state, "Failed to delete currency state index");
+            return DISCONNECT_FAILED;
+        }
+    }
     // unwind any consensus upgrades that may have been removed in the block
     ConnectedChains.CheckOracleUpgrades();
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
@@ -3785,6 +4365,374 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CTxPrecomputeCheck> txprecomputequeue(4);
+
+void ThreadTxPrecomputeCheck() {
+    RenameThread("verus-txprecomp");
+    txprecomputequeue.Thread();
+}
+
+/**
+ * Upgrade the records of a block tree index that fUpgraded does not yet accept, in batches, while the node runs.
+ * prepare is called on each batch without holding cs_main, for any disk reads it needs. rewrite is then called under
+ * cs_main with each record as read and its current value, and returns whether it upgraded the current value, which is
+ * written. Records that are rewritten by block connection in between are left to it.
+ */
+template <typename K, typename V>
+static bool UpgradeIndexRecords(char chPrefix,
+                                const boost::function<bool(const V &)> &fUpgraded,
+                                const boost::function<void(const std::vector<std::pair<K, V>> &)> &prepare,
+                                const boost::function<bool(const std::pair<K, V> &, V &)> &rewrite,
+                                size_t &nUpgraded)
+{
+    static const size_t UPGRADE_BATCH_ENTRIES = 1000;
+
+    K lastKey;
+    nUpgraded = 0;
+    while (true)
+    {
+        boost::this_thread::interruption_point();
+
+        std::vector<std::pair<K, V>> oldEntries;
+        if (!pblocktree->ReadRecordsToUpgrade(chPrefix, lastKey, UPGRADE_BATCH_ENTRIES, fUpgraded, oldEntries))
+        {
+            return error("%s: cannot read index", __func__);
+        }
+        if (!oldEntries.size())
+        {
+            return true;
+        }
+        lastKey = oldEntries.back().first;
+
+        prepare(oldEntries);
+
+        LOCK(cs_main);
+        std::vector<std::pair<K, V>> upgradedEntries;
+        for (auto &oneEntry : oldEntries)
+        {
+            V currentValue;
+            if (!pblocktree->Read(std::make_pair(chPrefix, oneEntry.first), currentValue) ||
+                fUpgraded(currentValue) ||
+                !rewrite(oneEntry, currentValue))
+            {
+                continue;
+            }
+            upgradedEntries.push_back(std::make_pair(oneEntry.first, currentValue));
+        }
+        if (!pblocktree->WriteRecords(chPrefix, upgradedEntries))
+        {
+            return error("%s: cannot write index", __func__);
+        }
+        nUpgraded += upgradedEntries.size();
+    }
+}
+
+void ThreadUpgradeAddressUnspentIndex()
+{
+    LogPrintf("Recording confirming blocks in address unspent index...\n");
+
+    // transactions are read without holding cs_main, and each block is only trusted if it is still active below
+    std::map<uint256, uint256> txBlocks;
+    size_t nUpgraded;
+    if (!UpgradeIndexRecords<CAddressUnspentKey, CAddressUnspentValue>(
+            DB_ADDRESSUNSPENTINDEX,
+            [](const CAddressUnspentValue &value) { return value.HasBlock(); },
+            [&txBlocks](const std::vector<CAddressUnspentDbEntry> &oldEntries) {
+                txBlocks.clear();
+                for (auto &oneEntry : oldEntries)
+                {
+                    if (!txBlocks.count(oneEntry.first.txhash))
+                    {
+                        CTransaction tx;
+                        uint256 hashBlock;
+                        myGetTransaction(oneEntry.first.txhash, tx, hashBlock, false);
+                        txBlocks[oneEntry.first.txhash] = hashBlock;
+                    }
+                }
+            },
+            [&txBlocks](const CAddressUnspentDbEntry &oldEntry, CAddressUnspentValue &currentValue) {
+                // outputs spent since they were read are no longer in the index
+                BlockMap::iterator blockIt = mapBlockIndex.find(txBlocks[oldEntry.first.txhash]);
+                if (blockIt == mapBlockIndex.end() || !chainActive.Contains(blockIt->second))
+                {
+                    return false;
+                }
+                currentValue.confirmedHeight = blockIt->second->GetHeight();
+                currentValue.blockHash = blockIt->second->GetBlockHash();
+                return true;
+            },
+            nUpgraded))
+    {
+        return;
+    }
+    // any records that could not be upgraded are still answered by reading their transactions
+    pblocktree->WriteFlag("addressunspentblocks", true);
+    LogPrintf("Recorded confirming blocks for %u address unspent index records\n", (unsigned int)nUpgraded);
+}
+
+void ThreadUpgradeTxIndex()
+{
+    LogPrintf("Recording block hashes in transaction index...\n");
+
+    // each block header is read and hashed once per batch, without holding cs_main
+    std::map<std::pair<int, unsigned int>, uint256> blockHashes;
+    size_t nUpgraded;
+    if (!UpgradeIndexRecords<uint256, CDiskTxPos>(
+            DB_TXINDEX,
+            [](const CDiskTxPos &pos) { return !pos.blockHash.IsNull(); },
+            [&blockHashes](const std::vector<std::pair<uint256, CDiskTxPos>> &oldEntries) {
+                blockHashes.clear();
+                for (auto &oneEntry : oldEntries)
+                {
+                    std::pair<int, unsigned int> blockPos(oneEntry.second.nFile, oneEntry.second.nPos);
+                    if (blockHashes.count(blockPos))
+                    {
+                        continue;
+                    }
+                    CAutoFile file(OpenBlockFile(oneEntry.second, true), SER_DISK, CLIENT_VERSION);
+                    CBlockHeader header;
+                    try {
+                        if (!file.IsNull())
+                        {
+                            file >> header;
+                            blockHashes[blockPos] = header.GetHash();
+                        }
+                    } catch (const std::exception& e) {
+                        LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+                    }
+                }
+            },
+            [&blockHashes](const std::pair<uint256, CDiskTxPos> &oldEntry, CDiskTxPos &currentPos) {
+                // entries moved to another block since they were read are left as they are
+                auto hashIt = blockHashes.find(std::make_pair(oldEntry.second.nFile, oldEntry.second.nPos));
+                if (hashIt == blockHashes.end() ||
+                    !mapBlockIndex.count(hashIt->second) ||
+                    currentPos.nFile != oldEntry.second.nFile ||
+                    currentPos.nPos != oldEntry.second.nPos)
+                {
+                    return false;
+                }
+                currentPos.blockHash = hashIt->second;
+                return true;
+            },
+            nUpgraded))
+    {
+        return;
+    }
+    // any entries that could not be upgraded are still answered by hashing their block headers
+    pblocktree->WriteFlag("txindexblocks", true);
+    LogPrintf("Recorded block hashes for %u transaction index entries\n", (unsigned int)nUpgraded);
+}
+
+// the coin supply that a block adds, from the block and its undo data
+struct CBlockSupplyDelta
+{
+    CAmount newCoins = 0;
+    CAmount immature = 0;
+    uint32_t maturity = 0;
+    CCurrencyValueMap currencies;
+};
+
+static CBlockSupplyDelta GetBlockSupplyDelta(const CBlock &block, const CBlockUndo &blockundo, uint32_t nHeight)
+{
+    CBlockSupplyDelta delta;
+    for (int i = 0; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = block.vtx[i];
+        for (auto &out : tx.vout)
+        {
+            if (tx.IsCoinBase() || !out.scriptPubKey.IsOpReturn())
+            {
+                delta.newCoins += out.nValue;
+            }
+            if (out.scriptPubKey.IsPayToCryptoCondition())
+            {
+                delta.currencies += out.ReserveOutValue();
+            }
+        }
+        if (i > 0 && i <= blockundo.vtxundo.size())
+        {
+            for (auto &spent : blockundo.vtxundo[i - 1].vprevout)
+            {
+                delta.newCoins -= spent.txout.nValue;
+                if (spent.txout.scriptPubKey.IsPayToCryptoCondition())
+                {
+                    delta.currencies -= spent.txout.ReserveOutValue();
+                }
+            }
+        }
+    }
+
+    // only the part of the coinbase that unlocks after this block is immature
+    std::map<uint32_t, int64_t> unlockBlockAmounts;
+    int64_t coinbaseAmount;
+    GetImmatureCoins(&unlockBlockAmounts, block, delta.maturity, coinbaseAmount, nHeight);
+    for (auto it = unlockBlockAmounts.upper_bound(nHeight); it != unlockBlockAmounts.end(); it++)
+    {
+        delta.immature += it->second;
+    }
+    return delta;
+}
+
+// sets the chain supply of a block whose parent has one, which only depends on the block's ancestors
+static void SetBlockSupply(CBlockIndex *pindex, const CBlockSupplyDelta &delta)
+{
+    AssertLockHeld(cs_main);
+    const CBlockIndex *pprev = pindex->pprev;
+    uint32_t nHeight = pindex->GetHeight();
+
+    pindex->newcoins = delta.newCoins;
+    pindex->zfunds = (pindex->nSproutValue ? *pindex->nSproutValue : 0) + pindex->nSaplingValue;
+    pindex->immature = delta.immature;
+    pindex->maturity = delta.maturity;
+    pindex->nChainTransparentSupply = pprev->nChainTransparentSupply + pindex->newcoins;
+    pindex->nChainShieldedSupply = pprev->nChainShieldedSupply + pindex->zfunds;
+
+    // coinbases that mature at this height leave the immature supply, which is either the one COINBASE_MATURITY
+    // blocks back or a time locked one
+    CAmount nImmature = pprev->nChainImmatureSupply + pindex->immature;
+    if (nHeight > COINBASE_MATURITY)
+    {
+        const CBlockIndex *pmaturing = pindex->GetAncestor(nHeight - COINBASE_MATURITY);
+        if (pmaturing && pmaturing->maturity == nHeight)
+        {
+            nImmature -= pmaturing->immature;
+        }
+    }
+    auto lockedRange = mapTimeLockedSupply.equal_range(nHeight);
+    for (auto it = lockedRange.first; it != lockedRange.second; it++)
+    {
+        if (it->second->GetHeight() < nHeight && pindex->GetAncestor(it->second->GetHeight()) == it->second)
+        {
+            nImmature -= it->second->immature;
+        }
+    }
+    pindex->nChainImmatureSupply = nImmature;
+    if (pindex->immature && pindex->maturity > nHeight + COINBASE_MATURITY)
+    {
+        mapTimeLockedSupply.insert(std::make_pair(pindex->maturity, pindex));
+    }
+
+    if (delta.currencies.valueMap.size())
+    {
+        CCurrencyValueMap currencySupply = pprev->pChainCurrencySupply ? *pprev->pChainCurrencySupply : CCurrencyValueMap();
+        currencySupply += delta.currencies;
+        pindex->pChainCurrencySupply = std::make_shared<const CCurrencyValueMap>(currencySupply);
+    }
+    else
+    {
+        pindex->pChainCurrencySupply = pprev->pChainCurrencySupply;
+    }
+
+    pindex->nStatus |= BLOCK_HAVE_SUPPLY;
+    setDirtyBlockIndex.insert(pindex);
+}
+
+// blocks at and below the returned height on the active chain have a stored supply, since a block only gets one
+// after its parent
+static int LastBlockWithSupply()
+{
+    AssertLockHeld(cs_main);
+    int low = -1, high = chainActive.Height();
+    while (low < high)
+    {
+        int mid = low + (high - low + 1) / 2;
+        if (chainActive[mid]->nStatus & BLOCK_HAVE_SUPPLY)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+void ThreadBackfillCoinSupply()
+{
+    static const int BACKFILL_BATCH_BLOCKS = 1000;
+
+    // a reindex or import connects the chain from the genesis block, which records the supply as it goes, and the
+    // active chain is empty until it starts, so wait for it to finish
+    while (true)
+    {
+        {
+            LOCK(cs_main);
+            CBlockIndex *pgenesis = chainActive.Genesis();
+            if (!fReindex && !fImporting && pgenesis)
+            {
+                if (!(pgenesis->nStatus & BLOCK_HAVE_SUPPLY))
+                {
+                    // no coins are ever spendable from the genesis block
+                    pgenesis->nStatus |= BLOCK_HAVE_SUPPLY;
+                    setDirtyBlockIndex.insert(pgenesis);
+                }
+                break;
+            }
+        }
+        MilliSleep(1000);
+    }
+
+    bool fLogged = false;
+    int nBackfilled = 0;
+    while (true)
+    {
+        boost::this_thread::interruption_point();
+
+        std::vector<CBlockIndex *> blocks;
+        {
+            LOCK(cs_main);
+            for (int nHeight = LastBlockWithSupply() + 1; nHeight <= chainActive.Height() && blocks.size() < BACKFILL_BATCH_BLOCKS; nHeight++)
+            {
+                blocks.push_back(chainActive[nHeight]);
+            }
+        }
+        if (!blocks.size() || blocks[0]->GetHeight() == 0)
+        {
+            break;
+        }
+        if (!fLogged)
+        {
+            LogPrintf("Recording coin supply in the block index from height %d...\n", blocks[0]->GetHeight());
+            fLogged = true;
+        }
+
+        // blocks and their undo data are read without holding cs_main
+        std::vector<CBlockSupplyDelta> deltas;
+        for (auto pindex : blocks)
+        {
+            boost::this_thread::interruption_point();
+            CBlock block;
+            CBlockUndo blockundo;
+            CDiskBlockPos undoPos = pindex->GetUndoPos();
+            if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus(), false) ||
+                undoPos.IsNull() ||
+                !UndoReadFromDisk(blockundo, undoPos, pindex->pprev->GetBlockHash()))
+            {
+                LogPrintf("%s: cannot read block or undo data at height %d, coinsupply will scan blocks above it\n", __func__, pindex->GetHeight());
+                return;
+            }
+            deltas.push_back(GetBlockSupplyDelta(block, blockundo, pindex->GetHeight()));
+        }
+
+        LOCK(cs_main);
+        for (int i = 0; i < blocks.size(); i++)
+        {
+            // blocks connected since they were read may already have a supply
+            if (!(blocks[i]->nStatus & BLOCK_HAVE_SUPPLY) && (blocks[i]->pprev->nStatus & BLOCK_HAVE_SUPPLY))
+            {
+                SetBlockSupply(blocks[i], deltas[i]);
+                nBackfilled++;
+            }
+        }
+    }
+    if (fLogged)
+    {
+        LogPrintf("Recorded coin supply for %d blocks\n", nBackfilled);
+    }
+}
+
 //
 // Called periodically asynchronously; alerts if it smells like
 // we're being fed a bad chain (blocks being generated much
@@ -3931,6 +4879,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::vector<CAddressIndexDbEntry> addressIndex;
     std::vector<CAddressUnspentDbEntry> addressUnspentIndex;
     std::vector<CSpentIndexDbEntry> spentIndex;
+    std::map<std::pair<unsigned int, size_t>, CCurrencyValueMap> spentReserves;
 
     CCheckQueueControl<CScriptCheck> control(fExpensiveChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
     CCurrencyDefinition newThisChain;
@@ -4014,6 +4963,12 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 pindex->hashSproutAnchor = tree.root();
                 // The genesis block contained no JoinSplits
                 pindex->hashFinalSproutRoot = pindex->hashSproutAnchor;
+                // nor any spendable coins, so the supply up to it is empty
+                if (!(pindex->nStatus & BLOCK_HAVE_SUPPLY))
+                {
+                    pindex->nStatus |= BLOCK_HAVE_SUPPLY;
+                    setDirtyBlockIndex.insert(pindex);
+                }
             }
             return true;
         }
@@ -4077,7 +5032,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
 
         nTimeStart = GetTimeMicros();
-        CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+        CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()), pindex->GetBlockHash());
         vPos.reserve(block.vtx.size());
         blockundo.vtxundo.reserve(block.vtx.size() - 1);
 
@@ -4118,8 +5073,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         std::map<uint160, int32_t> identityExportTransferCount;
         bool isPBaaS = CConstVerusSolutionVector::GetVersionByHeight(nHeight) >= CActivationHeight::ACTIVATE_PBAAS;
 
-        std::vector<PrecomputedTransactionData> txdata;
-        txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
+        // sized up front, as pointers to individual PrecomputedTransactionData must not get invalidated
+        std::vector<PrecomputedTransactionData> txdata(block.vtx.size());
 
         // duplicate checks combining identity reservation and imports as well as ID and currency exports
         // in addition to those done in ContextualCheckBlock, as we can expect valid prior block dependencies when we are here that will
@@ -4131,6 +5086,41 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         std::set<std::pair<uint160, uint160>> currencyDestAndExport;
         std::set<CUTXORef> orphanArbs;
 
+        // compute the signature hash data of every transaction, parse its outputs and decode their smart transaction
+        // objects, and verify the Sapling proofs of all shielded transactions in parallel before the ordered pass. each
+        // Sapling success is recorded in the Sapling proof cache, and ContextualCheckTransaction re-verifies anything
+        // that is not cached, so failures are reported with their precise reason in the ordered pass.
+        //
+        // the smart transaction prechecks called from ContextualCheckTransaction and the CReserveTransactionDescriptor
+        // below still run in the ordered pass, but read the parsed outputs and decoded objects cached on each
+        // transaction. what is left of them depends on chain state. prechecks such as PrecheckIdentityPrimary assert
+        // that cs_main is held by the calling thread, others read chainActive and fill the ConnectedChains currency
+        // cache through GetCurrencyDefinition, which also reads the mempool. the descriptor reads inputs through the
+        // CCoinsViewCache of this block, which is not thread safe and must already include the outputs of earlier
+        // transactions in the block.
+        {
+            bool fParallel = fExpensiveChecks && nScriptCheckThreads;
+            CCheckQueueControl<CTxPrecomputeCheck> precomputeControl(fParallel ? &txprecomputequeue : NULL);
+            std::vector<CTxPrecomputeCheck> vPrecomputeChecks;
+            vPrecomputeChecks.reserve(block.vtx.size());
+            for (unsigned int i = 0; i < block.vtx.size(); i++)
+            {
+                vPrecomputeChecks.push_back(CTxPrecomputeCheck(block.vtx[i], &txdata[i], chainparams, nHeight, fParallel));
+            }
+            if (fParallel)
+            {
+                precomputeControl.Add(vPrecomputeChecks);
+                precomputeControl.Wait();
+            }
+            else
+            {
+                for (auto &oneCheck : vPrecomputeChecks)
+                {
+                    oneCheck();
+                }
+            }
+        }
+
         for (unsigned int i = 0; i < block.vtx.size(); i++)
         {
             const CTransaction &tx = block.vtx[i];
@@ -4187,9 +5177,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 for (int j = 0; j < tx.vout.size(); j++)
                 {
                     auto &oneOut = tx.vout[j];
-                    COptCCParams p;
+                    const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(j);
+                    const COptCCParams &p = outDesc.p;
                     uint160 oneIdID;
-                    if (oneOut.scriptPubKey.IsPayToCryptoCondition(p) &&
+                    if (outDesc.isPayToCC &&
                         p.IsValid() &&
                         p.version >= p.VERSION_V3 &&
                         p.vData.size())
@@ -4478,6 +5469,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
                     const CTxIn input = tx.vin[j];
                     const CTxOut &prevout = view.GetOutputFor(tx.vin[j]);
+                    if (fBalanceIndex) {
+                        RecordSpentReserves(spentReserves, i, j, prevout);
+                    }
 
                     COptCCParams p;
                     if (prevout.scriptPubKey.IsPayToCryptoCondition(p))
@@ -4570,8 +5564,6 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                                     REJECT_INVALID, "bad-blk-sigops");
             }
 
-            txdata.emplace_back(tx);
-
             if (!tx.IsCoinBase())
             {
                 if (rtxd.IsValid())
@@ -4900,7 +5892,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                                     // record unspent output
                                     addressUnspentIndex.push_back(make_pair(
                                         CAddressUnspentKey(AddressTypeFromDest(dest), destID, txhash, k),
-                                        CAddressUnspentValue(out.nValue, out.scriptPubKey, heightOffsets[destID])));
+                                        CAddressUnspentValue(out.nValue, out.scriptPubKey, heightOffsets[destID], pindex->GetHeight(), pindex->GetBlockHash())));
                                 }
                                 else
                                 {
@@ -4912,7 +5904,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                                     // record unspent output
                                     addressUnspentIndex.push_back(make_pair(
                                         CAddressUnspentKey(AddressTypeFromDest(dest), destID, txhash, k),
-                                        CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight)));
+                                        CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight, pindex->GetHeight(), pindex->GetBlockHash())));
                                 }
                             }
                         }
@@ -4934,7 +5926,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                                 // record unspent output
                                 addressUnspentIndex.push_back(make_pair(
                                     CAddressUnspentKey(scriptType, addrHash, txhash, k),
-                                    CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->GetHeight())));
+                                    CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->GetHeight(), pindex->GetHeight(), pindex->GetBlockHash())));
                             }
                         }
                     }
@@ -5171,11 +6163,21 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         setDirtyBlockIndex.insert(pindex);
     }
 
+    // until the background job has reached this block's parent, its supply is left to that job
+    if (!(pindex->nStatus & BLOCK_HAVE_SUPPLY) && pindex->pprev && (pindex->pprev->nStatus & BLOCK_HAVE_SUPPLY))
+    {
+        SetBlockSupply(pindex, GetBlockSupplyDelta(block, blockundo, pindex->GetHeight()));
+    }
+
     ConnectNotarisations(block, pindex->GetHeight());
 
     if (fTxIndex)
+    {
         if (!pblocktree->WriteTxIndex(vPos))
             return AbortNode(state, "Failed to write transaction index");
+        // drop any copies cached from another block before the index moved them here
+        EraseCachedTransactions(block);
+    }
 
     if (fAddressIndex) {
         if (!pblocktree->WriteAddressIndex(addressIndex)) {
@@ -5185,12 +6187,45 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             return AbortNode(state, "Failed to write address unspent index");
         }
+
+        if (fBalanceIndex) {
+            uint256 hashApplied;
+            int nAppliedHeight;
+            if (!pblocktree->ReadAddressBalanceBlock(hashApplied, nAppliedHeight))
+                return AbortNode(state, "Failed to read address balance index");
+
+            // the balance index is written as blocks connect, but the chain state only when it is flushed, so after an
+            // unclean shutdown the blocks the index already includes are connected again, and must not be added twice.
+            // a last applied block missing from the block index was lost along with the chain state.
+            BlockMap::iterator appliedIt = mapBlockIndex.find(hashApplied);
+            bool fApplied = !hashApplied.IsNull() &&
+                            nAppliedHeight >= pindex->GetHeight() &&
+                            (appliedIt == mapBlockIndex.end() || appliedIt->second->GetAncestor(pindex->GetHeight()) == pindex);
+            if (!fApplied)
+            {
+                // indexes written before the last block was recorded are taken to be at the chain state
+                if (!hashApplied.IsNull() && (!pindex->pprev || hashApplied != pindex->pprev->GetBlockHash()))
+                    return AbortNode(state, "Address balance index does not match the chain, rebuild it with -reindex");
+
+                std::vector<CAddressBalanceDbEntry> balanceIndex;
+                GetAddressBalanceIndexEntries(block, addressIndex, spentReserves, balanceIndex);
+                if (!pblocktree->UpdateAddressBalanceIndex(balanceIndex, true, pindex->GetBlockHash(), pindex->GetHeight()))
+                    return AbortNode(state, "Failed to write address balance index");
+            }
+        }
     }
 
     if (fSpentIndex)
         if (!pblocktree->UpdateSpentIndex(spentIndex))
             return AbortNode(state, "Failed to write transaction index");
 
+    if (fCurrencyStateIndex) {
+        std::vector<CCurrencyStateIndexDbEntry> currencyStateIndex;
+        GetCurrencyStateIndexEntries(block, pindex->GetHeight(), currencyStateIndex);
+        if (!pblocktree->WriteCurrencyStateIndex(currencyStateIndex))
+            return AbortNode(state, "Failed to write currency state index");
+    }
+
     if (fTimestampIndex) {
         unsigned int logicalTS = pindex->nTime;
         unsigned int prevLogicalTS = 0;
@@ -5498,12 +6533,10 @@ bool static DisconnectTip(CValidationState &state, const CChainParams& chainpara
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         assert(view.Flush());
         DisconnectNotarisations(block);
+        EraseCachedTransactions(block);
     }
+    // the block's supply fields only depend on its ancestors, so they stay valid for when it is connected again
     pindexDelete->segid = -2;
-    pindexDelete->newcoins = 0;
-    pindexDelete->zfunds = 0;
-    pindexDelete->maturity = 0;
-    pindexDelete->immature = 0;
 
     LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     uint256 sproutAnchorAfterDisconnect = pcoinsTip->GetBestAnchor(SPROUT);
@@ -7164,6 +8197,7 @@ void UnlinkPrunedFiles(std::set<int>& setFilesToPrune)
 {
     for (set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileMaps.Forget(*it);
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -7298,10 +8332,12 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
 bool static LoadBlockIndexDB()
 {
     const CChainParams& chainparams = Params();
+    int64_t nStartTime = GetTimeMillis(), nPhaseTime = nStartTime;
     LogPrintf("%s: start loading guts\n", __func__);
     if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
         return false;
-    LogPrintf("%s: loaded guts\n", __func__);
+    LogPrintf("%s: loaded guts for %u blocks in %dms\n", __func__, (unsigned int)mapBlockIndex.size(), GetTimeMillis() - nPhaseTime);
+    nPhaseTime = GetTimeMillis();
     boost::this_thread::interruption_point();
 
     // Calculate chainPower
@@ -7316,10 +8352,25 @@ bool static LoadBlockIndexDB()
     //fprintf(stderr,"load blockindexDB paired %u\n",(uint32_t)time(NULL));
     sort(vSortedByHeight.begin(), vSortedByHeight.end());
     //fprintf(stderr,"load blockindexDB sorted %u\n",(uint32_t)time(NULL));
+    LogPrintf("%s: sorted by height in %dms\n", __func__, GetTimeMillis() - nPhaseTime);
+    nPhaseTime = GetTimeMillis();
     BOOST_FOREACH(const PAIRTYPE(int, CBlockIndex*)& item, vSortedByHeight)
     {
         CBlockIndex* pindex = item.second;
         pindex->chainPower = (pindex->pprev ? CChainPower(pindex) + pindex->pprev->chainPower : CChainPower(pindex)) + GetBlockProof(*pindex);
+        if (pindex->nStatus & BLOCK_HAVE_SUPPLY)
+        {
+            // each currency supply map is read separately, so blocks that did not change it share their parent's again
+            if (pindex->pprev && pindex->pChainCurrencySupply && pindex->pprev->pChainCurrencySupply &&
+                *pindex->pChainCurrencySupply == *pindex->pprev->pChainCurrencySupply)
+            {
+                pindex->pChainCurrencySupply = pindex->pprev->pChainCurrencySupply;
+            }
+            if (pindex->immature && pindex->maturity > pindex->GetHeight() + COINBASE_MATURITY)
+            {
+                mapTimeLockedSupply.insert(std::make_pair(pindex->maturity, pindex));
+            }
+        }
         // We can link the chain of blocks for which we've received transactions at some point.
         // Pruned nodes may have deleted the block.
         if (pindex->nTx > 0) {
@@ -7383,6 +8434,8 @@ bool static LoadBlockIndexDB()
         //komodo_pindex_init(pindex,(int32_t)pindex->GetHeight());
     }
     //fprintf(stderr,"load blockindexDB chained %u\n",(uint32_t)time(NULL));
+    LogPrintf("%s: computed chain power in %dms\n", __func__, GetTimeMillis() - nPhaseTime);
+    nPhaseTime = GetTimeMillis();
 
     // Load block file info
     pblocktree->ReadLastBlockFile(nLastBlockFile);
@@ -7421,6 +8474,9 @@ bool static LoadBlockIndexDB()
         }
     }
 
+    LogPrintf("%s: checked block files in %dms\n", __func__, GetTimeMillis() - nPhaseTime);
+    nPhaseTime = GetTimeMillis();
+
     // Check whether we have ever pruned block & undo files
     pblocktree->ReadFlag("prunedblockfiles", fHavePruned);
     if (fHavePruned)
@@ -7438,6 +8494,12 @@ bool static LoadBlockIndexDB()
     pblocktree->ReadFlag("idindex", fIdIndex);
     LogPrintf("%s: identity index %s\n", __func__, fIdIndex ? "enabled" : "disabled");
 
+    pblocktree->ReadFlag("currencystateindex", fCurrencyStateIndex);
+    LogPrintf("%s: currency state index %s\n", __func__, fCurrencyStateIndex ? "enabled" : "disabled");
+
+    pblocktree->ReadFlag("balanceindex", fBalanceIndex);
+    LogPrintf("%s: address balance index %s\n", __func__, fBalanceIndex ? "enabled" : "disabled");
+
     pblocktree->ReadFlag("conversionindex", fConversionIndex);
     LogPrintf("%s: conversion index %s\n", __func__, fConversionIndex ? "enabled" : "disabled");
 
@@ -7479,6 +8541,8 @@ bool static LoadBlockIndexDB()
         //komodo_pindex_init(pindex,(int32_t)pindex->GetHeight());
     }
 
+    LogPrintf("%s: loaded block index in %dms\n", __func__, GetTimeMillis() - nStartTime);
+
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     if (it == mapBlockIndex.end())
@@ -7815,8 +8879,10 @@ void UnloadBlockIndex()
     mapOrphanTransactionsByPrev.clear();
     nSyncStarted = 0;
     mapBlocksUnlinked.clear();
+    mapTimeLockedSupply.clear();
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
+    blockFileMaps.Clear();
     nBlockSequenceId = 1;
     mapBlockSource.clear();
     mapBlocksInFlight.clear();
@@ -7867,6 +8933,14 @@ bool InitBlockIndex(const CChainParams& chainparams)
     fIdIndex = GetBoolArg("-idindex", false);
     pblocktree->WriteFlag("idindex", fIdIndex);
 
+    // Use the provided setting for -currencystateindex in the new database
+    fCurrencyStateIndex = GetBoolArg("-currencystateindex", false);
+    pblocktree->WriteFlag("currencystateindex", fCurrencyStateIndex);
+
+    // Use the provided setting for -balanceindex in the new database
+    fBalanceIndex = GetBoolArg("-balanceindex", false);
+    pblocktree->WriteFlag("balanceindex", fBalanceIndex);
+
     // Use the provided setting for -conversionindex in the new database
     /*
     fConversionIndex = GetBoolArg("-conversionindex", false);
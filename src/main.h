@@ -16,6 +16,7 @@
 #include "coins.h"
 #include "consensus/consensus.h"
 #include "consensus/upgrades.h"
+#include "lrucache.h"
 #include "net.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
@@ -31,11 +32,14 @@
 #include "uint256.h"
 #include "cheatcatcher.h"
 #include "addressindex.h"
+#include "currencystateindex.h"
+#include "balanceindex.h"
 #include "timestampindex.h"
 
 #include <algorithm>
 #include <exception>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdint.h>
 #include <string>
@@ -95,6 +99,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Default for -maxsaplingcachesize, memory in MiB for transactions with verified Sapling proofs */
+static const unsigned int DEFAULT_MAX_SAPLING_CACHE_SIZE = 10;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -111,6 +117,10 @@ static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 static const unsigned int DATABASE_WRITE_INTERVAL = 15 * 60;
 /** Time to wait (in seconds) between flushing chainstate to disk. */
 static const unsigned int DATABASE_FLUSH_INTERVAL = 24 * 60 * 60;
+/** Default for -blockcachesize, memory in MiB for recently read blocks */
+static const unsigned int DEFAULT_BLOCK_CACHE_SIZE = 0;
+/** Approximate memory in bytes used to cache transactions read from blocks through the transaction index. */
+static const size_t TX_CACHE_SIZE = 32 << 20;
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
@@ -158,6 +168,9 @@ typedef boost::unordered_map<uint256, CBlockIndex*, BlockHasher> BlockMap;
 extern BlockMap mapBlockIndex;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
+extern CAmount nLastBlockFees;
+extern int64_t nLastBlockAssemblyTime;  //!< microseconds
+extern uint64_t nLastBlockScannedTx;
 extern const std::string verusDataSignaturePrefix;
 extern const std::string verusDataSignaturePrefix;
 extern CWaitableCriticalSection csBestBlock;
@@ -168,6 +181,8 @@ extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
 extern bool fIdIndex;
+extern bool fCurrencyStateIndex;
+extern bool fBalanceIndex;
 extern bool fConversionIndex;
 
 // START insightexplorer
@@ -270,6 +285,14 @@ bool ProcessMessages(CNode* pfrom);
 bool SendMessages(CNode* pto, bool fSendTrickle);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the per-transaction precompute and Sapling proof checking thread */
+void ThreadTxPrecomputeCheck();
+/** Record the confirming block in address unspent index records written before it was part of them */
+void ThreadUpgradeAddressUnspentIndex();
+/** Record the block hash in transaction index entries written before it was part of them */
+void ThreadUpgradeTxIndex();
+/** Record the coin supply of active blocks connected before the block index stored it */
+void ThreadBackfillCoinSupply();
 /** Try to detect Partition (network isolation) attacks against us */
 void PartitionCheck(bool (*initialDownloadCheck)(const CChainParams&), CCriticalSection& cs, const CBlockIndex *const &bestHeader);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
@@ -283,6 +306,14 @@ std::string GetWarnings(const std::string& strFor);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256 &hash, CTransaction &tx, const Consensus::Params& params, uint256 &hashBlock, bool fAllowSlow = false);
 bool GetTransaction(const uint256 &hash, CTransaction &tx, uint256 &hashBlock, bool fAllowSlow = false);
+/** Recently read block transactions and the hashes of their blocks, by txid */
+typedef CShardedLRUCache<uint256, std::pair<std::shared_ptr<const CTransaction>, uint256>> CTransactionCache;
+/** Retrieve a transaction in a block through the transaction index, sharing recently read transactions between callers */
+bool GetBlockTransaction(const uint256 &hash, std::shared_ptr<const CTransaction> &ptx, uint256 &hashBlock);
+/** Remove the transactions of a block that is being connected or disconnected from the transaction cache, after its
+ *  transaction index entries are written. Reads that were in flight at the time are not cached. */
+void EraseCachedTransactions(const CBlock &block);
+CTransactionCache::CStats GetTransactionCacheStats();
 /** Find the best known block, and make it the tip of the block chain */
 bool ActivateBestChain(CValidationState& state, const CChainParams& chainparams, const CBlock* pblock = NULL);
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
@@ -484,16 +515,62 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the context-free validation work for one transaction of a block, which can run on the
+ * check queue workers ahead of the ordered pass of ConnectBlock. It fills the transaction's precomputed signature
+ * hash data in place, parses its outputs and decodes their smart transaction objects into the transaction's output
+ * descriptors and, if requested, verifies its Sapling proofs and binding signature, recording successes in the
+ * Sapling proof cache that ContextualCheckTransaction consults. The smart transaction prechecks and reserve
+ * transaction descriptors themselves depend on chain state that is only safe to read under cs_main on the
+ * connecting thread, so they only read those results. Stores references to the transaction and its
+ * PrecomputedTransactionData slot, and always succeeds, so that one failure never leaves other slots unfilled.
+ */
+class CTxPrecomputeCheck
+{
+private:
+    const CTransaction *ptxTo;
+    PrecomputedTransactionData *txdata;
+    const CChainParams *chainparams;
+    int nHeight;
+    bool fCheckSapling;
+
+public:
+    CTxPrecomputeCheck(): ptxTo(0), txdata(0), chainparams(0), nHeight(0), fCheckSapling(false) {}
+    CTxPrecomputeCheck(const CTransaction& txToIn, PrecomputedTransactionData *txdataIn, const CChainParams &chainparamsIn, int nHeightIn, bool fCheckSaplingIn) :
+        ptxTo(&txToIn), txdata(txdataIn), chainparams(&chainparamsIn), nHeight(nHeightIn), fCheckSapling(fCheckSaplingIn) {}
+
+    bool operator()();
+
+    void swap(CTxPrecomputeCheck &check) {
+        std::swap(ptxTo, check.ptxTo);
+        std::swap(txdata, check.txdata);
+        std::swap(chainparams, check.chainparams);
+        std::swap(nHeight, check.nHeight);
+        std::swap(fCheckSapling, check.fCheckSapling);
+    }
+};
+
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &hashes);
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool GetAddressIndex(const uint160& addressHash, int type, std::vector<CAddressIndexDbEntry> &addressIndex, int start = 0, int end = 0);
+/** Get the current balance and total received of an address from the balance index */
+bool GetAddressBalance(const uint160& addressHash, int type, CAddressBalanceValue &balance);
+/** Visit address index entries in a height range from the newest, until visit returns false */
+bool GetAddressIndexReverse(const uint160& addressHash, int type, const boost::function<bool(const CAddressIndexDbEntry &)> &visit, int start = 0, int end = 0);
+/** Get at most maxEntries of the newest address index entries in a height range, in the same order as GetAddressIndex */
+bool GetLatestAddressIndex(const uint160& addressHash, int type, std::vector<CAddressIndexDbEntry> &addressIndex, size_t maxEntries, int start = 0, int end = 0);
 bool GetAddressUnspent(const uint160& addressHash, int type, std::vector<CAddressUnspentDbEntry>& unspentOutputs);
+/** Paged forms of GetAddressIndex and GetAddressUnspent, which read at most maxEntries entries after the key after, or from the first if it is null */
+bool GetAddressIndexPage(const uint160& addressHash, int type, const CAddressIndexKey *after, size_t maxEntries, std::vector<CAddressIndexDbEntry> &addressIndex, int start = 0, int end = 0);
+bool GetAddressUnspentPage(const uint160& addressHash, int type, const CAddressUnspentKey *after, size_t maxEntries, std::vector<CAddressUnspentDbEntry>& unspentOutputs);
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
 bool ReadBlockFromDisk(int32_t height, CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, bool checkPOW);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, bool checkPOW);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Keep up to nCacheBytes of recently read blocks in memory, or none if it is zero */
+void InitBlockCache(size_t nCacheBytes);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -82,6 +82,153 @@ public:
 
 uint64_t nLastBlockTx = 0;
 uint64_t nLastBlockSize = 0;
+CAmount nLastBlockFees = 0;
+int64_t nLastBlockAssemblyTime = 0;
+uint64_t nLastBlockScannedTx = 0;
+
+// The part of CreateNewBlock's mempool scan that only depends on a transaction and the chain tip: whether it is still
+// valid at the next height and what its inputs are worth. It is kept across templates for the same tip, so each new
+// template only looks up the inputs of transactions that entered the mempool since the last one.
+struct CMempoolScanEntry
+{
+    bool fInvalid = false;                  // coinbase, expired or failing contextual checks at the next height
+    bool fReserve = false;                  // reserve input values are only summed for reserve transactions
+    bool fMissingInputs = false;
+    double dInputPriority = 0;              // sum of value * confirmations of inputs in the chain
+    CAmount nInputValue = 0;
+    CCurrencyValueMap reserveInputValue;
+    std::vector<uint256> mempoolInputs;     // in mempool transactions spent, once for each input
+    unsigned int nTxSize = 0;
+    uint64_t nGeneration = 0;               // last scan that found the transaction in the mempool
+};
+
+class CMempoolScanCache
+{
+    uint256 hashTip;
+    uint64_t nGeneration = 0;
+    std::map<uint256, CMempoolScanEntry> entries;
+
+public:
+    // starts a scan on top of pindexPrev, dropping everything if the tip changed
+    void Begin(const CBlockIndex *pindexPrev)
+    {
+        if (pindexPrev->GetBlockHash() != hashTip)
+        {
+            entries.clear();
+            hashTip = pindexPrev->GetBlockHash();
+        }
+        nGeneration++;
+    }
+
+    // the cached entry for a mempool transaction, or NULL if it must be scanned, which also happens when a mempool
+    // transaction it spends has left the pool
+    CMempoolScanEntry *Find(const uint256 &hash, bool fReserve)
+    {
+        auto it = entries.find(hash);
+        if (it == entries.end() || it->second.fReserve != fReserve)
+        {
+            return NULL;
+        }
+        for (auto &oneInput : it->second.mempoolInputs)
+        {
+            if (!mempool.mapTx.count(oneInput))
+            {
+                return NULL;
+            }
+        }
+        it->second.nGeneration = nGeneration;
+        return &it->second;
+    }
+
+    CMempoolScanEntry *Add(const uint256 &hash, const CMempoolScanEntry &entry)
+    {
+        CMempoolScanEntry &newEntry = entries[hash] = entry;
+        newEntry.nGeneration = nGeneration;
+        return &newEntry;
+    }
+
+    // forgets transactions that have left the mempool since the last scan
+    void End()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.nGeneration != nGeneration)
+            {
+                it = entries.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+};
+
+// only used while holding cs_main and mempool.cs
+static CMempoolScanCache mempoolScanCache;
+
+static CMempoolScanEntry ScanMempoolTransaction(const CTransaction &tx, uint32_t nHeight, bool checkContext, bool fReserve,
+                                                CCoinsViewCache &view, const CCoinbaseCurrencyState &currencyState)
+{
+    CMempoolScanEntry entry;
+    entry.fReserve = fReserve;
+    entry.nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+
+    CValidationState state;
+    if (tx.IsCoinBase() ||
+        IsExpiredTx(tx, nHeight) ||
+        (checkContext && !ContextualCheckTransaction(tx, state, Params(), nHeight, 0)))
+    {
+        entry.fInvalid = true;
+        return entry;
+    }
+
+    for (auto &txin : tx.vin)
+    {
+        if (!view.HaveCoins(txin.prevout.hash))
+        {
+            // This should never happen; all transactions in the memory
+            // pool should connect to either transactions in the chain
+            // or other transactions in the memory pool.
+            auto parentIt = mempool.mapTx.find(txin.prevout.hash);
+            if (parentIt == mempool.mapTx.end())
+            {
+                LogPrintf("ERROR: mempool transaction missing input\n");
+                LogPrint("mempool", "mempool transaction missing input");
+                entry.fMissingInputs = true;
+                entry.mempoolInputs.clear();
+                return entry;
+            }
+
+            // Has to wait for dependencies
+            const CTransaction &otx = parentIt->GetTx();
+            entry.mempoolInputs.push_back(txin.prevout.hash);
+            // consider reserve outputs and set priority according to their value here as well
+            if (fReserve)
+            {
+                entry.reserveInputValue += otx.vout[txin.prevout.n].ReserveOutValue();
+            }
+            entry.nInputValue += otx.vout[txin.prevout.n].nValue;
+            continue;
+        }
+        const CCoins* coins = view.AccessCoins(txin.prevout.hash);
+        assert(coins);
+
+        CCurrencyValueMap reserveValueIn;
+        if (fReserve)
+        {
+            reserveValueIn = coins->vout[txin.prevout.n].ReserveOutValue();
+            entry.reserveInputValue += reserveValueIn;
+        }
+
+        CAmount nValueIn = coins->vout[txin.prevout.n].nValue;
+        int nConf = nHeight - coins->nHeight;
+
+        entry.dInputPriority += ((double)((reserveValueIn.valueMap.size() ? currencyState.ReserveToNative(reserveValueIn) : 1) + nValueIn)) * nConf;
+        entry.nInputValue += nValueIn;
+    }
+    return entry;
+}
 
 // We want to sort transactions by priority and fee rate, so:
 typedef boost::tuple<double, CFeeRate, const CTransaction*> TxPriority;
@@ -2120,6 +2267,7 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
     uint256 cbHash;
 
     CBlockIndex* pindexPrev = 0;
+    int64_t nAssemblyStart = 0;
     bool loop = true;
     while (loop)
     {
@@ -2808,6 +2956,7 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
         // done calling out, take locks for the rest
         LOCK(cs_main);
         LOCK2(smartTransactionCS, mempool.cs);
+        nAssemblyStart = GetTimeMicros();
 
         CCoinsViewCache view(pcoinsTip);
         SaplingMerkleTree sapling_tree;
@@ -2892,6 +3041,8 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
         std::set<CUTXORef> orphanArbs;
 
         // now add transactions from the mem pool to the priority heap
+        mempoolScanCache.Begin(pindexPrev);
+        uint64_t nScannedTx = 0;
         for (CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.begin();
              mi != mempool.mapTx.end(); ++mi)
         {
@@ -2908,10 +3059,17 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
             {
                 continue;
             }
-            if (tx.IsCoinBase() ||
-                IsExpiredTx(tx, nHeight) ||
-                (mi->GetHeight() != nHeight &&
-                 !ContextualCheckTransaction(tx, state, Params(), nHeight, 0)))
+
+            CReserveTransactionDescriptor rtxd;
+            bool isReserve = mempool.IsKnownReserveTransaction(hash, rtxd);
+
+            CMempoolScanEntry *pscan = mempoolScanCache.Find(hash, isReserve);
+            if (!pscan)
+            {
+                pscan = mempoolScanCache.Add(hash, ScanMempoolTransaction(tx, nHeight, mi->GetHeight() != nHeight, isReserve, view, currencyState));
+                nScannedTx++;
+            }
+            if (pscan->fInvalid)
             {
                 txesToRemove.push_back(tx);
                 continue;
@@ -2921,9 +3079,6 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
             double dPriority = 0;
             CAmount nTotalIn = 0;
             CCurrencyValueMap totalReserveIn;
-            bool fMissingInputs = false;
-            CReserveTransactionDescriptor rtxd;
-            bool isReserve = mempool.IsKnownReserveTransaction(hash, rtxd);
 
             CAmount delayedFee = 0;
             if (isReserve)
@@ -3047,100 +3202,25 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
                 }
             }
 
-            for (int inNum = 0; inNum < tx.vin.size(); inNum++)
+            if (pscan->fMissingInputs)
             {
-                const CTxIn &txin = tx.vin[inNum];
-                CAmount nValueIn = 0;
-                CCurrencyValueMap reserveValueIn;
-
-                // Read prev transaction
-                if (!view.HaveCoins(txin.prevout.hash))
-                {
-                    // This should never happen; all transactions in the memory
-                    // pool should connect to either transactions in the chain
-                    // or other transactions in the memory pool.
-                    if (!mempool.mapTx.count(txin.prevout.hash))
-                    {
-                        LogPrintf("ERROR: mempool transaction missing input\n");
-                        LogPrint("mempool", "mempool transaction missing input");
-                        fMissingInputs = true;
-
-                        txesToRemove.push_back(tx);
-        
-                        if (porphan)
-                        {
-                            for (int inNumStart = 0; inNumStart < inNum; inNumStart++)
-                            {
-                                auto depIt = mapDependers.find(tx.vin[inNumStart].prevout.hash);
-                                if (depIt != mapDependers.end())
-                                {
-                                    for (auto orphanIt = depIt->second.end(); orphanIt != depIt->second.begin(); )
-                                    {
-                                        orphanIt--;
-                                        if (*orphanIt == porphan)
-                                        {
-                                            bool isPriorIt = orphanIt != depIt->second.begin();
-                                            auto nextIt = !isPriorIt ? depIt->second.end() : orphanIt;
-                                            if (isPriorIt)
-                                            {
-                                                nextIt--;
-                                            }
-                                            depIt->second.erase(orphanIt);
-                                            if (isPriorIt)
-                                            {
-                                                orphanIt = ++nextIt;
-                                            }
-                                            else
-                                            {
-                                                orphanIt = depIt->second.begin();
-                                            }
-                                        }
-                                    }
-                                    if (!depIt->second.size())
-                                    {
-                                        mapDependers.erase(tx.vin[inNumStart].prevout.hash);
-                                    }
-                                }
-                            }
-                            vOrphan.pop_back();
-                        }
-                        break;
-                    }
-
-                    // Has to wait for dependencies
-                    if (!porphan)
-                    {
-                        // Use list for automatic deletion
-                        vOrphan.push_back(COrphan(&tx));
-                        porphan = &vOrphan.back();
-                    }
-                    mapDependers[txin.prevout.hash].push_back(porphan);
-                    porphan->setDependsOn.insert(txin.prevout.hash);
-
-                    const CTransaction &otx = mempool.mapTx.find(txin.prevout.hash)->GetTx();
-                    // consider reserve outputs and set priority according to their value here as well
-                    if (isReserve)
-                    {
-                        totalReserveIn += otx.vout[txin.prevout.n].ReserveOutValue();
-                    }
-                    nTotalIn += otx.vout[txin.prevout.n].nValue;
-                    continue;
-                }
-                const CCoins* coins = view.AccessCoins(txin.prevout.hash);
-                assert(coins);
-
-                if (isReserve)
+                txesToRemove.push_back(tx);
+                continue;
+            }
+            for (auto &oneInput : pscan->mempoolInputs)
+            {
+                if (!porphan)
                 {
-                    reserveValueIn = coins->vout[txin.prevout.n].ReserveOutValue();
-                    totalReserveIn += reserveValueIn;
+                    // Use list for automatic deletion
+                    vOrphan.push_back(COrphan(&tx));
+                    porphan = &vOrphan.back();
                 }
-
-                nValueIn = coins->vout[txin.prevout.n].nValue;
-                int nConf = nHeight - coins->nHeight;
-
-                dPriority += ((double)((reserveValueIn.valueMap.size() ? currencyState.ReserveToNative(reserveValueIn) : 1) + nValueIn)) * nConf;
-                nTotalIn += nValueIn;
+                mapDependers[oneInput].push_back(porphan);
+                porphan->setDependsOn.insert(oneInput);
             }
+            dPriority += pscan->dInputPriority;
+            nTotalIn += pscan->nInputValue;
+            totalReserveIn += pscan->reserveInputValue;
 
             // prioritize notarizations, finalizations, and exports for our notary chain
             if (rtxd.IsNotaryPrioritized() || rtxd.IsExport())
@@ -3150,10 +3230,8 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
             }
             nTotalIn += tx.GetShieldedValueIn();
 
-            if (fMissingInputs) continue;
-
             // Priority is sum(valuein * age) / modified_txsize
-            unsigned int nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+            unsigned int nTxSize = pscan->nTxSize;
             dPriority = tx.ComputePriority(dPriority, nTxSize);
 
             CAmount nDeltaValueIn = nTotalIn + (totalReserveIn.valueMap.count(VERUS_CHAINID) ? totalReserveIn.valueMap[VERUS_CHAINID] : 0);
@@ -3174,6 +3252,9 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
             }
         }
 
+        mempoolScanCache.End();
+        nLastBlockScannedTx = nScannedTx;
+
         std::set<uint256> arbTxOrphans;
         for (auto &oneOrphanArb : orphanArbs)
         {
@@ -3785,6 +3866,7 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
 
         nLastBlockTx = nBlockTx;
         nLastBlockSize = nBlockSize;
+        nLastBlockFees = nFees;
 
         blocktime = std::max(pindexPrev->GetMedianTimePast(), GetAdjustedTime());
 
@@ -3853,6 +3935,10 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const std::vecto
     unsigned int extraNonce = 0;
     IncrementExtraNonce(pblock, pindexPrev, extraNonce, true);
 
+    nLastBlockAssemblyTime = GetTimeMicros() - nAssemblyStart;
+    LogPrint("bench", "%s: assembled %u transactions in %.2fms, %u scanned from the mempool\n", __func__,
+             (unsigned int)nLastBlockTx, 0.001 * nLastBlockAssemblyTime, (unsigned int)nLastBlockScannedTx);
+
     return pblocktemplate.release();
 }
 
@@ -4747,6 +4833,12 @@ void static BitcoinMiner_noeq()
                             printf("  hash: %s\ntarget: %s", hashStr.c_str(), ArithToUint256(ourTarget).GetHex().c_str());
 #endif
                             printf("\n");
+                            // GetHash hashes the canonical header exactly when the header's PBaaS data checks out, so when that
+                            // agrees with what the nonce loop hashed, validation need not compute the hash again
+                            if (verusSolutionPBaaS == (pblock->HasPBaaSHeader() != 0 && pblock->CheckNonCanonicalData()))
+                            {
+                                pblock->CacheHash(hashResult);
+                            }
 #ifdef ENABLE_WALLET
                             ProcessBlockFound(pblock, *pwallet, reservekey);
 #else
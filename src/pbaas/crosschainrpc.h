@@ -23,6 +23,7 @@
 #include "boost/algorithm/string.hpp"
 #include "pbaas/vdxf.h"
 #include "utilstrencodings.h"
+#include "flatmap.h"
 
 static const int DEFAULT_RPC_TIMEOUT=900;
 static const uint32_t PBAAS_VERSION = 1;
@@ -387,7 +388,8 @@ extern int64_t AmountFromValueNoErr(const UniValue& value);
 class CCurrencyValueMap
 {
 public:
-    std::map<uint160, int64_t> valueMap;
+    // most maps hold one or two currencies, which then need no heap allocation
+    flatmap<2, uint160, int64_t> valueMap;
 
     CCurrencyValueMap() {}
     CCurrencyValueMap(const CCurrencyValueMap &operand) : valueMap(operand.valueMap) {}
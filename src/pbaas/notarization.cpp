@@ -1071,46 +1071,55 @@ bool CPBaaSNotarization::GetLastNotarization(const uint160 &currencyID,
                                              CTransaction *txOut)
 {
     CPBaaSNotarization notarization;
-    std::vector<CAddressIndexDbEntry> notarizationIndex;
-    // get the last notarization in the indicated height for this currency, which is valid by definition for a token
-    if (GetAddressIndex(CCrossChainRPCData::GetConditionID(currencyID, CPBaaSNotarization::NotaryNotarizationKey()), CScript::P2IDX, notarizationIndex, startHeight, endHeight))
+
+    // unless the transaction is needed, the currency state index has the notarization without reading any transactions
+    if (fCurrencyStateIndex && !txOutIdx && !txOut)
     {
-        // filter out all transactions that do not spend from the notarization thread, or originate as the
-        // chain definition
-        for (auto it = notarizationIndex.rbegin(); it != notarizationIndex.rend(); it++)
+        CCurrencyStateIndexDbEntry stateEntry;
+        if (pblocktree->ReadLastCurrencyState(currencyID, startHeight, endHeight, stateEntry) &&
+            (notarization = CPBaaSNotarization(stateEntry.second)).IsValid())
+        {
+            *this = notarization;
+        }
+        return notarization.IsValid();
+    }
+
+    // get the last notarization in the indicated height for this currency, which is valid by definition for a token.
+    // the index is walked from the newest entry, so only entries after the one we want are read.
+    GetAddressIndexReverse(CCrossChainRPCData::GetConditionID(currencyID, CPBaaSNotarization::NotaryNotarizationKey()), CScript::P2IDX,
+        [&](const CAddressIndexDbEntry &indexEntry)
         {
             // first unspent notarization that is valid is the one we want, skip spending
-            if (it->first.spending)
+            if (indexEntry.first.spending)
             {
-                continue;
+                return true;
             }
             LOCK(mempool.cs);
             CTransaction oneTx;
             uint256 blkHash;
-            if (myGetTransaction(it->first.txhash, oneTx, blkHash))
+            if (myGetTransaction(indexEntry.first.txhash, oneTx, blkHash))
             {
-                if ((notarization = CPBaaSNotarization(oneTx.vout[it->first.index].scriptPubKey)).IsValid())
+                if ((notarization = CPBaaSNotarization(oneTx.vout[indexEntry.first.index].scriptPubKey)).IsValid())
                 {
                     *this = notarization;
                     if (txOutIdx)
                     {
-                        *txOutIdx = *it;
+                        *txOutIdx = indexEntry;
                     }
                     if (txOut)
                     {
                         *txOut = oneTx;
                     }
-                    break;
+                    return false;
                 }
             }
             else
             {
-                LogPrintf("%s: error transaction %s not found, may need reindexing\n", __func__, it->first.txhash.GetHex().c_str());
-                printf("%s: error transaction %s not found, may need reindexing\n", __func__, it->first.txhash.GetHex().c_str());
-                continue;
+                LogPrintf("%s: error transaction %s not found, may need reindexing\n", __func__, indexEntry.first.txhash.GetHex().c_str());
+                printf("%s: error transaction %s not found, may need reindexing\n", __func__, indexEntry.first.txhash.GetHex().c_str());
             }
-        }
-    }
+            return true;
+        }, startHeight, endHeight);
     return notarization.IsValid();
 }
 
@@ -4902,7 +4911,7 @@ bool CPBaaSNotarization::CreateAcceptedNotarization(const CCurrencyDefinition &e
     std::vector<CAddressIndexDbEntry> addressIndex;
     uint160 notarizationIdxKey = CCrossChainRPCData::GetConditionID(newNotarization.currencyID, CPBaaSNotarization::EarnedNotarizationKey(), objHashCheck);
     if ((mempool.getAddressIndex({{notarizationIdxKey, CScript::P2IDX}}, memResults) && memResults.size()) ||
-        GetAddressIndex(notarizationIdxKey, CScript::P2IDX, addressIndex) && addressIndex.size())
+        GetLatestAddressIndex(notarizationIdxKey, CScript::P2IDX, addressIndex, 1) && addressIndex.size())
     {
         return state.Error(errorPrefix + " Cannot create accepted notarization. Notarization already present on chain.");
     }
@@ -8830,29 +8839,34 @@ bool CPBaaSNotarization::FindFinalizedIndexByVDXFKey(const uint160 &notarization
 {
     bool retVal = false;
     std::vector<CAddressIndexDbEntry> addressIndex;
-    if (!GetAddressIndex(notarizationIdxKey, CScript::P2IDX, addressIndex) || !addressIndex.size())
-    {
-        if (LogAcceptCategory("verbose"))
-        {
-            LogPrint("notarization", "No transaction data for index key - not necessarily an error\n");
-        }
-        return retVal;
-    }
-
     if (selectLast)
     {
-        for (int i = addressIndex.size() - 1; i >= 0; i--)
+        // only read back to the last entry that is not a spend
+        GetAddressIndexReverse(notarizationIdxKey, CScript::P2IDX, [&](const CAddressIndexDbEntry &oneIndexEntry)
         {
-            auto &oneIndexEntry = addressIndex[i];
+            addressIndex.push_back(oneIndexEntry);
             if (oneIndexEntry.first.spending)
             {
-                continue;
+                return true;
             }
             earnedNotarizationIndex = oneIndexEntry;
-            break;
-        }
+            return false;
+        });
     }
     else
+    {
+        GetAddressIndex(notarizationIdxKey, CScript::P2IDX, addressIndex);
+    }
+    if (!addressIndex.size())
+    {
+        if (LogAcceptCategory("verbose"))
+        {
+            LogPrint("notarization", "No transaction data for index key - not necessarily an error\n");
+        }
+        return retVal;
+    }
+
+    if (!selectLast)
     {
         for (auto &oneIndexEntry : addressIndex)
         {
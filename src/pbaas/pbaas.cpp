@@ -4879,7 +4879,9 @@ bool PrecheckReserveTransfer(const CTransaction &tx, int32_t outNum, CValidation
 {
     // do a basic sanity check that this reserve transfer's values are consistent and that it includes the
     // basic fees required to cover the transfer
-    COptCCParams p;
+    const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(outNum);
+    const COptCCParams &p = outDesc.p;
+    std::shared_ptr<const CReserveTransfer> cachedTransfer;
     CReserveTransfer rt;
 
     uint32_t chainHeight = chainActive.Height();
@@ -4894,11 +4896,11 @@ bool PrecheckReserveTransfer(const CTransaction &tx, int32_t outNum, CValidation
         return state.Error("DeFi functions temporarily disabled for security alert by notification oracle. Reserve transfer rejected " + rt.ToUniValue().write(1,2));
     }
 
-    if (tx.vout[outNum].scriptPubKey.IsPayToCryptoCondition(p) &&
+    if (outDesc.isPayToCC &&
         p.IsValid() &&
         p.evalCode == EVAL_RESERVE_TRANSFER &&
-        p.vData.size() &&
-        (rt = CReserveTransfer(p.vData[0])).IsValid() &&
+        (cachedTransfer = outDesc.GetObject<CReserveTransfer>()) &&
+        (rt = *cachedTransfer).IsValid() &&
         rt.TotalCurrencyOut().valueMap[ASSETCHAINS_CHAINID] == tx.vout[outNum].nValue &&
         (rt.IsArbitrageOnly() || p.IsEvalPKOut()) &&
         rt.destination.AuxDestCount() <= 3)
@@ -7618,34 +7620,28 @@ bool CConnectedChains::GetExportProofs(uint32_t height,
 
 bool CConnectedChains::GetReserveDeposits(const uint160 &currencyID, const CCoinsViewCache &view, std::vector<CInputDescriptor> &reserveDeposits)
 {
-    std::vector<CAddressUnspentDbEntry> confirmedUTXOs;
-    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> unconfirmedUTXOs;
-
     LOCK(mempool.cs);
 
     CCoins coin;
 
+    // GetUnspentByIndex reads both the confirmed and mempool indexes
     uint160 depositIndexKey = CReserveDeposit::ReserveDepositIndexKey(currencyID);
-    if (!GetAddressUnspent(depositIndexKey, CScript::P2IDX, confirmedUTXOs) ||
-        !mempool.getAddressIndex(std::vector<std::pair<uint160, int32_t>>({{depositIndexKey, CScript::P2IDX}}), unconfirmedUTXOs))
+    std::vector<std::pair<CInputDescriptor, uint32_t>> outputs;
+    if (!GetUnspentByIndex(depositIndexKey, outputs))
     {
         LogPrintf("%s: Cannot read address indexes\n", __func__);
         return false;
     }
-    std::vector<std::pair<CInputDescriptor, uint32_t>> outputs;
-    if (GetUnspentByIndex(depositIndexKey, outputs))
+    for (auto &oneOutput : outputs)
     {
-        for (auto &oneOutput : outputs)
+        COptCCParams p;
+        if (!mempool.mapNextTx.count(COutPoint(oneOutput.first.txIn.prevout.hash, oneOutput.first.txIn.prevout.n)) &&
+            view.GetCoins(oneOutput.first.txIn.prevout.hash, coin) &&
+            coin.IsAvailable(oneOutput.first.txIn.prevout.n) &&
+            oneOutput.first.scriptPubKey.IsPayToCryptoCondition(p) && p.IsValid() && p.evalCode == EVAL_RESERVE_DEPOSIT)
         {
-            COptCCParams p;
-            if (!mempool.mapNextTx.count(COutPoint(oneOutput.first.txIn.prevout.hash, oneOutput.first.txIn.prevout.n)) &&
-                view.GetCoins(oneOutput.first.txIn.prevout.hash, coin) &&
-                coin.IsAvailable(oneOutput.first.txIn.prevout.n) &&
-                oneOutput.first.scriptPubKey.IsPayToCryptoCondition(p) && p.IsValid() && p.evalCode == EVAL_RESERVE_DEPOSIT)
-            {
-                reserveDeposits.push_back(CInputDescriptor(oneOutput.first.scriptPubKey, oneOutput.first.nValue,
-                                                            CTxIn(oneOutput.first.txIn.prevout.hash, oneOutput.first.txIn.prevout.n)));
-            }
+            reserveDeposits.push_back(CInputDescriptor(oneOutput.first.scriptPubKey, oneOutput.first.nValue,
+                                                        CTxIn(oneOutput.first.txIn.prevout.hash, oneOutput.first.txIn.prevout.n)));
         }
     }
     return true;
@@ -7668,11 +7664,17 @@ bool CConnectedChains::GetUnspentByIndex(const uint160 &indexID, std::vector<std
 
     for (auto &oneConfirmed : confirmedUTXOs)
     {
+        if (spentInMempool.count(COutPoint(oneConfirmed.first.txhash, oneConfirmed.first.index)))
+        {
+            continue;
+        }
+
+        // records written before they included their block need the transaction read to find it
         BlockMap::iterator blockIt;
-        std::pair<CTransaction, uint256> txAndBlkHash;
-        if (spentInMempool.count(COutPoint(oneConfirmed.first.txhash, oneConfirmed.first.index)) ||
-            !myGetTransaction(oneConfirmed.first.txhash, txAndBlkHash.first, txAndBlkHash.second) ||
-            (blockIt = mapBlockIndex.find(txAndBlkHash.second)) == mapBlockIndex.end() ||
+        uint256 blockHash = oneConfirmed.second.blockHash;
+        CTransaction tx;
+        if ((!oneConfirmed.second.HasBlock() && !myGetTransaction(oneConfirmed.first.txhash, tx, blockHash)) ||
+            (blockIt = mapBlockIndex.find(blockHash)) == mapBlockIndex.end() ||
             !chainActive.Contains(blockIt->second))
         {
             continue;
@@ -970,8 +970,8 @@ public:
 
     std::map<uint160, CUpgradeDescriptor> activeUpgradesByKey;
 
-    LRUCache<uint160, std::tuple<uint32_t, uint256, CCurrencyDefinition>> currencyDefCache;  // protected by cs_main, so doesn't need sync
-    LRUCache<std::tuple<uint160, uint256, bool>, CCoinbaseCurrencyState> currencyStateCache; // cached currency states @ heights + updated flag
+    CShardedLRUCache<uint160, std::tuple<uint32_t, uint256, CCurrencyDefinition>> currencyDefCache;  // safe to read from any thread
+    CShardedLRUCache<std::tuple<uint160, uint256, bool>, CCoinbaseCurrencyState> currencyStateCache; // cached currency states @ heights + updated flag
 
     // make earned notarizations for one or more notary chains
     std::map<uint160, CNotarySystemInfo> notarySystems;
@@ -998,8 +998,8 @@ public:
     CSemaphore sem_submitthread;
 
     CConnectedChains() :
-        currencyDefCache(3000, 0.1F, false),
-        currencyStateCache(1000, 0.1F, false),
+        currencyDefCache(8 << 20),
+        currencyStateCache(4 << 20),
         lastBlockHeight(0),
         readyToStart(false),
         earnedNotarizationHeight(0),
@@ -1890,7 +1890,324 @@ CCoinbaseCurrencyState::CCoinbaseCurrencyState(const UniValue &obj) : CCurrencyS
     }
 }
 
-CAmount CalculateFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
+// Deterministic fixed point kernel for the bonding curve functions below. Values are unsigned 128 bit integers with
+// FIXED_FRAC_BITS fractional bits and every operation truncates, so results depend only on integer arithmetic. A result
+// is only returned when the kernel's error bound proves that it rounds to the same satoshi amount as the
+// cpp_dec_float_50 reference, which callers fall back to otherwise.
+namespace {
+
+typedef unsigned __int128 fixed_uint128;
+
+const int FIXED_FRAC_BITS = 120;
+const int FIXED_ATANH_BITS = 124;
+const int FIXED_OUT_BITS = 60;                                  // fractional bits of satoshi amounts before rounding
+const fixed_uint128 FIXED_ONE = (fixed_uint128)1 << FIXED_FRAC_BITS;
+const fixed_uint128 FIXED_LN2 = ((fixed_uint128)0xb17217f7d1cf79ULL << 64) | 0xabc9e3b39803f2f6ULL;
+
+const uint64_t FIXED_ROUNDING_MARGIN = (uint64_t)1 << 10;         // least distance from a whole satoshi to accept
+
+// full 256 bit product of a and b
+void FixedMul256(fixed_uint128 a, fixed_uint128 b, fixed_uint128 &hi, fixed_uint128 &lo)
+{
+    uint64_t a0 = (uint64_t)a, a1 = (uint64_t)(a >> 64), b0 = (uint64_t)b, b1 = (uint64_t)(b >> 64);
+    fixed_uint128 p00 = (fixed_uint128)a0 * b0;
+    fixed_uint128 p01 = (fixed_uint128)a0 * b1;
+    fixed_uint128 p10 = (fixed_uint128)a1 * b0;
+    fixed_uint128 p11 = (fixed_uint128)a1 * b1;
+    fixed_uint128 mid = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+    lo = (mid << 64) | (uint64_t)p00;
+    hi = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+}
+
+// hi:lo >> shift, false if the result does not fit in 126 bits
+bool FixedShiftRight256(fixed_uint128 hi, fixed_uint128 lo, int shift, fixed_uint128 &result)
+{
+    if (shift >= 256)
+    {
+        result = 0;
+        return true;
+    }
+    if (shift >= 128)
+    {
+        result = hi >> (shift - 128);
+    }
+    else if (shift > 0)
+    {
+        if (hi >> shift)
+        {
+            return false;
+        }
+        result = (hi << (128 - shift)) | (lo >> shift);
+    }
+    else
+    {
+        if (hi || (lo >> (126 + shift)))
+        {
+            return false;
+        }
+        result = lo << -shift;
+    }
+    return (result >> 126) == 0;
+}
+
+// a * b >> bits, false if the result does not fit
+bool FixedMul(fixed_uint128 a, fixed_uint128 b, fixed_uint128 &result, int bits=FIXED_FRAC_BITS)
+{
+    fixed_uint128 hi, lo;
+    FixedMul256(a, b, hi, lo);
+    return FixedShiftRight256(hi, lo, bits, result);
+}
+
+// floor(a * mul / div)
+bool FixedMulDiv64(fixed_uint128 a, uint64_t mul, uint64_t div, fixed_uint128 &result)
+{
+    fixed_uint128 hi, lo;
+    FixedMul256(a, mul, hi, lo);
+    if (hi >= div)
+    {
+        return false;
+    }
+    fixed_uint128 cur = (hi << 64) | (uint64_t)(lo >> 64);
+    fixed_uint128 q1 = cur / div;
+    cur = ((cur % div) << 64) | (uint64_t)lo;
+    result = (q1 << 64) | (cur / div);
+    return true;
+}
+
+// floor(num * 2^FIXED_ATANH_BITS / den) for num < den < 2^72
+fixed_uint128 FixedDivFraction(fixed_uint128 num, fixed_uint128 den)
+{
+    fixed_uint128 q = 0;
+    for (int bits = FIXED_ATANH_BITS; bits > 0; bits -= 56)
+    {
+        int step = bits < 56 ? bits : 56;
+        num <<= step;
+        q = (q << step) | (num / den);
+        num %= den;
+    }
+    return q;
+}
+
+// atanh(z) = z + z^3/3 + z^5/5 + ..., z in FIXED_ATANH_BITS
+bool FixedAtanhSeries(fixed_uint128 z, fixed_uint128 &sum)
+{
+    fixed_uint128 z2;
+    if (!FixedMul(z, z, z2, FIXED_ATANH_BITS))
+    {
+        return false;
+    }
+    sum = z;
+    fixed_uint128 power = z;
+    for (uint64_t j = 3; power; j += 2)
+    {
+        if (!FixedMul(power, z2, power, FIXED_ATANH_BITS))
+        {
+            return false;
+        }
+        sum += power / j;
+    }
+    return true;
+}
+
+// e^x = 1 + x + x^2/2! + ..., x < 1
+bool FixedExpSeries(fixed_uint128 x, fixed_uint128 &sum)
+{
+    sum = FIXED_ONE;
+    fixed_uint128 term = FIXED_ONE;
+    for (uint64_t n = 1; term; n++)
+    {
+        if (!FixedMul(term, x, term))
+        {
+            return false;
+        }
+        term /= n;
+        sum += term;
+    }
+    return true;
+}
+
+// ln(1 + i/64) in FIXED_ATANH_BITS and e^(i/64) for i < 64, which shorten the series to a few terms
+struct CFixedTables
+{
+    fixed_uint128 ln[64];
+    fixed_uint128 exp[64];
+    bool fValid;
+    CFixedTables() : fValid(true)
+    {
+        for (int i = 0; i < 64 && fValid; i++)
+        {
+            fixed_uint128 lnHalf = 0;
+            fValid = FixedAtanhSeries(FixedDivFraction(i, 128 + i), lnHalf) &&
+                     FixedExpSeries((fixed_uint128)i << (FIXED_FRAC_BITS - 6), exp[i]);
+            ln[i] = lnHalf << 1;
+        }
+    }
+};
+
+const CFixedTables &FixedTables()
+{
+    static const CFixedTables tables;
+    return tables;
+}
+
+// natural log of n >= 1
+bool FixedLn(uint64_t n, fixed_uint128 &result)
+{
+    if (!FixedTables().fValid)
+    {
+        return false;
+    }
+    int k = 0;
+    while (k < 63 && (n >> (k + 1)))
+    {
+        k++;
+    }
+    // with n = 2^k * c * m, c = 1 + i/64 <= m, ln(n) = k * ln(2) + ln(c) + 2 * atanh(z), z = (m - c) / (m + c) < 1/129
+    fixed_uint128 scaled = (fixed_uint128)n << 6;
+    int i = (int)((scaled >> k) - 64);
+    fixed_uint128 c = (fixed_uint128)(64 + i) << k;
+    fixed_uint128 z = FixedDivFraction(scaled - c, scaled + c), atanhZ;
+    if (!FixedAtanhSeries(z, atanhZ))
+    {
+        return false;
+    }
+    fixed_uint128 lnm = FixedTables().ln[i] + (atanhZ << 1);
+    result = FIXED_LN2 * k + (lnm >> (FIXED_ATANH_BITS - FIXED_FRAC_BITS));
+    return true;
+}
+
+// splits e^x or e^-x for x >= 0 into 2^k * mantissa, with a mantissa in [1, 2]
+bool FixedExp(fixed_uint128 x, bool negate, int64_t &k, fixed_uint128 &mantissa)
+{
+    if (!FixedTables().fValid)
+    {
+        return false;
+    }
+    fixed_uint128 quotient = x / FIXED_LN2;
+    fixed_uint128 rem = x - quotient * FIXED_LN2;
+    k = (int64_t)quotient;
+    if (negate)
+    {
+        // e^-x = 2^-(k + 1) * e^(ln(2) - rem)
+        k = -(k + 1);
+        rem = FIXED_LN2 - rem;
+    }
+    int i = (int)(rem >> (FIXED_FRAC_BITS - 6));
+    fixed_uint128 expRem;
+    return FixedExpSeries(rem - ((fixed_uint128)i << (FIXED_FRAC_BITS - 6)), expRem) &&
+           FixedMul(FixedTables().exp[i], expRem, mantissa);
+}
+
+// truncates a non-negative amount with FIXED_OUT_BITS fractional bits to whole satoshis, as the reference does. false
+// if the amount does not fit an int64_t or is too close to a whole satoshi to be sure of agreeing with the reference.
+// the kernel's error is below (scale + amount) * 2^-100 satoshis, where scale is the supply or reserve that the curve
+// multiplies, and this margin is sixteen times that, while the reference's own error is smaller still.
+bool FixedTruncateToAmount(fixed_uint128 amount, uint64_t scale, int64_t &result)
+{
+    fixed_uint128 whole = amount >> FIXED_OUT_BITS;
+    if (whole >= (fixed_uint128)INT64_MAX)
+    {
+        return false;
+    }
+    uint64_t fraction = (uint64_t)amount & (((uint64_t)1 << FIXED_OUT_BITS) - 1);
+    uint64_t margin = (uint64_t)(((fixed_uint128)scale + whole) >> 36) + FIXED_ROUNDING_MARGIN;
+    if (fraction <= margin || fraction >= ((uint64_t)1 << FIXED_OUT_BITS) - margin)
+    {
+        return false;
+    }
+    result = (int64_t)whole;
+    return true;
+}
+
+}
+
+// supply * ((1 + reserveIn / reserve) ^ ratio - 1)
+bool FixedPointFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio, CAmount &fractionalOut)
+{
+    if (NormalizedReserveIn <= 0 ||
+        Supply < 0 ||
+        NormalizedReserve < 0 ||
+        reserveRatio < CCurrencyState::MIN_RESERVE_RATIO ||
+        reserveRatio > CCurrencyState::MAX_RESERVE_RATIO)
+    {
+        return false;
+    }
+    uint64_t supply = Supply ? Supply : 1;
+    uint64_t reserve = NormalizedReserve ? NormalizedReserve : 1;
+
+    fixed_uint128 lnAfter, lnBefore, x;
+    if (!FixedLn(reserve + NormalizedReserveIn, lnAfter) ||
+        !FixedLn(reserve, lnBefore) ||
+        lnAfter < lnBefore ||
+        !FixedMulDiv64(lnAfter - lnBefore, reserveRatio, CCurrencyState::MAX_RESERVE_RATIO, x))
+    {
+        return false;
+    }
+
+    int64_t k;
+    fixed_uint128 mantissa, hi, lo, total;
+    if (!FixedExp(x, false, k, mantissa))
+    {
+        return false;
+    }
+    FixedMul256(mantissa, supply, hi, lo);
+    if (k > 64 || !FixedShiftRight256(hi, lo, FIXED_FRAC_BITS - FIXED_OUT_BITS - k, total))
+    {
+        return false;
+    }
+    fixed_uint128 supplyBefore = (fixed_uint128)supply << FIXED_OUT_BITS;
+    return total >= supplyBefore && FixedTruncateToAmount(total - supplyBefore, supply, fractionalOut);
+}
+
+// reserve * (1 - (1 - fractionalIn / supply) ^ (1 / ratio))
+bool FixedPointReserveOut(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio, CAmount &reserveOut)
+{
+    if (FractionalIn <= 0 ||
+        Supply < 0 ||
+        NormalizedReserve < 0 ||
+        reserveRatio < CCurrencyState::MIN_RESERVE_RATIO ||
+        reserveRatio > CCurrencyState::MAX_RESERVE_RATIO)
+    {
+        return false;
+    }
+    uint64_t supply = Supply ? Supply : 1;
+    uint64_t reserve = NormalizedReserve ? NormalizedReserve : 1;
+    if (FractionalIn >= supply)
+    {
+        return false;
+    }
+
+    fixed_uint128 lnBefore, lnAfter, x;
+    if (!FixedLn(supply, lnBefore) ||
+        !FixedLn(supply - FractionalIn, lnAfter) ||
+        lnBefore < lnAfter)
+    {
+        return false;
+    }
+    // when nearly all of the supply is sold, whether the reference rounds the remaining reserve to zero depends on its
+    // precision, so leave that to the reference
+    if (!FixedMulDiv64(lnBefore - lnAfter, CCurrencyState::MAX_RESERVE_RATIO, reserveRatio, x) ||
+        x >= ((fixed_uint128)128 << FIXED_FRAC_BITS))
+    {
+        return false;
+    }
+
+    int64_t k;
+    fixed_uint128 mantissa, hi, lo, remaining;
+    if (!FixedExp(x, true, k, mantissa))
+    {
+        return false;
+    }
+    FixedMul256(mantissa, reserve, hi, lo);
+    if (!FixedShiftRight256(hi, lo, FIXED_FRAC_BITS - FIXED_OUT_BITS - k, remaining))
+    {
+        return false;
+    }
+    fixed_uint128 reserveBefore = (fixed_uint128)reserve << FIXED_OUT_BITS;
+    return remaining <= reserveBefore && FixedTruncateToAmount(reserveBefore - remaining, reserve, reserveOut);
+}
+
+CAmount CalculateFractionalOutReference(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
 {
     static cpp_dec_float_50 one("1");
     static cpp_dec_float_50 bigSatoshi("100000000");
@@ -1921,7 +2238,7 @@ CAmount CalculateFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmo
     return fractionalOut;
 }
 
-CAmount CalculateReserveOut(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
+CAmount CalculateReserveOutReference(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
 {
     static cpp_dec_float_50 one("1");
     static cpp_dec_float_50 bigSatoshi("100000000");
@@ -1952,6 +2269,26 @@ CAmount CalculateReserveOut(CAmount FractionalIn, CAmount Supply, CAmount Normal
     return reserveOut;
 }
 
+CAmount CalculateFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
+{
+    CAmount fractionalOut;
+    if (FixedPointFractionalOut(NormalizedReserveIn, Supply, NormalizedReserve, reserveRatio, fractionalOut))
+    {
+        return fractionalOut;
+    }
+    return CalculateFractionalOutReference(NormalizedReserveIn, Supply, NormalizedReserve, reserveRatio);
+}
+
+CAmount CalculateReserveOut(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio)
+{
+    CAmount reserveOut;
+    if (FixedPointReserveOut(FractionalIn, Supply, NormalizedReserve, reserveRatio, reserveOut))
+    {
+        return reserveOut;
+    }
+    return CalculateReserveOutReference(FractionalIn, Supply, NormalizedReserve, reserveRatio);
+}
+
 
 void DumpConvertData(const std::vector<CAmount> &_inputReserves,
                      const std::vector<CAmount> &_inputFractional,
@@ -2835,9 +3172,10 @@ CReserveTransactionDescriptor::CReserveTransactionDescriptor(const CTransaction
 
     for (int i = 0; i < tx.vout.size(); i++)
     {
-        COptCCParams p;
+        const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(i);
+        const COptCCParams &p = outDesc.p;
 
-        if (tx.vout[i].scriptPubKey.IsPayToCryptoCondition(p) && p.IsValid())
+        if (outDesc.isPayToCC && p.IsValid())
         {
             switch (p.evalCode)
             {
@@ -2920,14 +3258,14 @@ CReserveTransactionDescriptor::CReserveTransactionDescriptor(const CTransaction
 
                 case EVAL_RESERVE_DEPOSIT:
                 {
-                    CReserveDeposit rd;
-                    if (!p.vData.size() || !(rd = CReserveDeposit(p.vData[0])).IsValid())
+                    std::shared_ptr<const CReserveDeposit> rd = outDesc.GetObject<CReserveDeposit>();
+                    if (!rd || !rd->IsValid())
                     {
                         flags &= ~IS_VALID;
                         flags |= IS_REJECT;
                         return;
                     }
-                    for (auto &oneCur : rd.reserveValues.valueMap)
+                    for (auto &oneCur : rd->reserveValues.valueMap)
                     {
                         if (oneCur.first != ASSETCHAINS_CHAINID)
                         {
@@ -2939,14 +3277,14 @@ CReserveTransactionDescriptor::CReserveTransactionDescriptor(const CTransaction
 
                 case EVAL_RESERVE_OUTPUT:
                 {
-                    CTokenOutput ro;
-                    if (!p.vData.size() || !(ro = CTokenOutput(p.vData[0])).IsValid())
+                    std::shared_ptr<const CTokenOutput> ro = outDesc.GetObject<CTokenOutput>();
+                    if (!ro || !ro->IsValid())
                     {
                         flags &= ~IS_VALID;
                         flags |= IS_REJECT;
                         return;
                     }
-                    for (auto &oneCur : ro.reserveValues.valueMap)
+                    for (auto &oneCur : ro->reserveValues.valueMap)
                     {
                         if (oneCur.first != ASSETCHAINS_CHAINID && oneCur.second)
                         {
@@ -2958,15 +3296,15 @@ CReserveTransactionDescriptor::CReserveTransactionDescriptor(const CTransaction
 
                 case EVAL_RESERVE_TRANSFER:
                 {
-                    CReserveTransfer rt;
-                    if (!p.vData.size() || !(rt = CReserveTransfer(p.vData[0])).IsValid())
+                    std::shared_ptr<const CReserveTransfer> rt = outDesc.GetObject<CReserveTransfer>();
+                    if (!rt || !rt->IsValid())
                     {
                         flags &= ~IS_VALID;
                         flags |= IS_REJECT;
                         return;
                     }
                     flags |= IS_RESERVETRANSFER;
-                    AddReserveTransfer(rt);
+                    AddReserveTransfer(*rt);
                 }
                 break;
 
@@ -2981,18 +3319,18 @@ CReserveTransactionDescriptor::CReserveTransactionDescriptor(const CTransaction
                         //UniValue jsonTx(UniValue::VOBJ);
                         //TxToUniv(tx, uint256(), jsonTx);
                         //printf("%s: Coinbase transaction:\n%s\n", __func__, jsonTx.write(1,2).c_str());
-                        CCurrencyDefinition oneCurDef;
-                        COptCCParams tempP;
+                        std::shared_ptr<const CCurrencyDefinition> oneCurDef;
                         for (int j = 0; j < tx.vout.size(); j++)
                         {
-                            if (tx.vout[j].scriptPubKey.IsPayToCryptoCondition(tempP) &&
-                                tempP.IsValid() &&
-                                tempP.evalCode == EVAL_CURRENCY_DEFINITION &&
-                                tempP.vData.size() &&
-                                (oneCurDef = CCurrencyDefinition(tempP.vData[0])).IsValid())
+                            const CTxOutDescriptor &curDesc = tx.GetOutputDescriptor(j);
+                            if (curDesc.isPayToCC &&
+                                curDesc.p.IsValid() &&
+                                curDesc.p.evalCode == EVAL_CURRENCY_DEFINITION &&
+                                (oneCurDef = curDesc.GetObject<CCurrencyDefinition>()) &&
+                                oneCurDef->IsValid())
                             {
-                                //printf("%s: Adding currency:\n%s\n", __func__, oneCurDef.ToUniValue().write(1,2).c_str());
-                                ConnectedChains.UpdateCachedCurrency(oneCurDef, nHeight);
+                                //printf("%s: Adding currency:\n%s\n", __func__, oneCurDef->ToUniValue().write(1,2).c_str());
+                                ConnectedChains.UpdateCachedCurrency(*oneCurDef, nHeight);
                             }
                         }
                         loadedCurrencies = true;
@@ -7427,13 +7765,15 @@ bool PrecheckFeePool(const CTransaction &tx, int32_t outNum, CValidationState &s
 bool PrecheckReserveDeposit(const CTransaction &tx, int32_t outNum, CValidationState &state, uint32_t height)
 {
     // do a basic sanity check that this reserve transfer's values are consistent
-    COptCCParams p;
+    const CTxOutDescriptor &outDesc = tx.GetOutputDescriptor(outNum);
+    const COptCCParams &p = outDesc.p;
+    std::shared_ptr<const CReserveDeposit> cachedDeposit;
     CReserveDeposit rd;
-    if (tx.vout[outNum].scriptPubKey.IsPayToCryptoCondition(p) &&
+    if (outDesc.isPayToCC &&
         p.IsValid() &&
         p.evalCode == EVAL_RESERVE_DEPOSIT &&
-        p.vData.size() &&
-        (rd = CReserveDeposit(p.vData[0])).IsValid() &&
+        (cachedDeposit = outDesc.GetObject<CReserveDeposit>()) &&
+        (rd = *cachedDeposit).IsValid() &&
         rd.reserveValues.valueMap[ASSETCHAINS_CHAINID] == tx.vout[outNum].nValue &&
         p.IsEvalPKOut())
     {
@@ -1209,6 +1209,16 @@ public:
     }
 };
 
+// bonding curve conversions of a fractional currency, in satoshis. the reference implementations are defined by
+// cpp_dec_float_50 arithmetic, and the fixed point versions return false rather than risk a result that differs from
+// them by even one satoshi. CalculateFractionalOut and CalculateReserveOut use the fixed point kernel when it can decide.
+CAmount CalculateFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio);
+CAmount CalculateReserveOut(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio);
+CAmount CalculateFractionalOutReference(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio);
+CAmount CalculateReserveOutReference(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio);
+bool FixedPointFractionalOut(CAmount NormalizedReserveIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio, CAmount &fractionalOut);
+bool FixedPointReserveOut(CAmount FractionalIn, CAmount Supply, CAmount NormalizedReserve, int32_t reserveRatio, CAmount &reserveOut);
+
 class CCurrencyState
 {
 public:
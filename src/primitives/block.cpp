@@ -18,6 +18,23 @@ extern uint160 VERUS_CHAINID;
 // default hash algorithm for block
 uint256 (CBlockHeader::*CBlockHeader::hashFunction)() const = &CBlockHeader::GetSHA256DHash;
 
+std::atomic<uint64_t> CBlockHeader::nGetHashCalls(0);
+std::atomic<uint64_t> CBlockHeader::nHashesComputed(0);
+
+struct CBlockHeaderHashCache
+{
+    uint256 (CBlockHeader::*hashFunction)() const;
+    CBlockHeader header;
+    uint256 hash;
+
+    CBlockHeaderHashCache(const CBlockHeader &hashedHeader, const uint256 &headerHash) :
+        hashFunction(CBlockHeader::hashFunction), header(hashedHeader), hash(headerHash)
+    {
+        // only the hashed fields are kept
+        header.ClearHashCache();
+    }
+};
+
 // does not check for height / sapling upgrade, etc. this should not be used to get block proofs
 // on a pre-VerusPoP chain
 arith_uint256 GetCompactPower(const uint256 &nNonce, uint32_t nBits, int32_t version)
@@ -276,6 +293,25 @@ bool CBlockHeader::AddUpdatePBaaSHeader()
     return false;
 }
 
+uint256 CBlockHeader::GetHash() const
+{
+    nGetHashCalls++;
+    std::shared_ptr<const CBlockHeaderHashCache> cache = std::atomic_load(&hashCache);
+    if (cache && cache->hashFunction == hashFunction && cache->header.HashedDataEquals(*this))
+    {
+        return cache->hash;
+    }
+    nHashesComputed++;
+    uint256 hash = (this->*hashFunction)();
+    CacheHash(hash);
+    return hash;
+}
+
+void CBlockHeader::CacheHash(const uint256 &hash) const
+{
+    std::atomic_store(&hashCache, std::shared_ptr<const CBlockHeaderHashCache>(std::make_shared<CBlockHeaderHashCache>(*this, hash)));
+}
+
 uint256 CBlockHeader::GetSHA256DHash() const
 {
     return SerializeHash(*this);
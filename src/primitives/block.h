@@ -13,11 +13,14 @@
 #include "arith_uint256.h"
 #include "primitives/solutiondata.h"
 #include "mmr.h"
+#include <atomic>
+#include <memory>
 #include <curl/curl.h>
 // does not check for height / sapling upgrade, etc. this should not be used to get block proofs
 // on a pre-VerusPoP chain
 arith_uint256 GetCompactPower(const uint256 &nNonce, uint32_t nBits, int32_t version=CPOSNonce::VERUS_V2);
 class CBlockHeader;
+struct CBlockHeaderHashCache;
 
 // nodes for the entire chain MMR
 typedef CMMRPowerNode<CBLAKE2bWriter> ChainMMRNode;
@@ -40,6 +43,10 @@ public:
 
     static uint256 (CBlockHeader::*hashFunction)() const;
 
+    // calls to GetHash and the number of them that had to compute the hash, for benchmarks
+    static std::atomic<uint64_t> nGetHashCalls;
+    static std::atomic<uint64_t> nHashesComputed;
+
     int32_t nVersion;
     uint256 hashPrevBlock;
     uint256 hashMerkleRoot;
@@ -54,6 +61,33 @@ public:
         SetNull();
     }
 
+    CBlockHeader(const CBlockHeader &other) :
+        nVersion(other.nVersion),
+        hashPrevBlock(other.hashPrevBlock),
+        hashMerkleRoot(other.hashMerkleRoot),
+        hashFinalSaplingRoot(other.hashFinalSaplingRoot),
+        nTime(other.nTime),
+        nBits(other.nBits),
+        nNonce(other.nNonce),
+        nSolution(other.nSolution),
+        hashCache(std::atomic_load(&other.hashCache))
+    {
+    }
+
+    CBlockHeader &operator=(const CBlockHeader &other)
+    {
+        nVersion = other.nVersion;
+        hashPrevBlock = other.hashPrevBlock;
+        hashMerkleRoot = other.hashMerkleRoot;
+        hashFinalSaplingRoot = other.hashFinalSaplingRoot;
+        nTime = other.nTime;
+        nBits = other.nBits;
+        nNonce = other.nNonce;
+        nSolution = other.nSolution;
+        std::atomic_store(&hashCache, std::atomic_load(&other.hashCache));
+        return *this;
+    }
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -78,6 +112,7 @@ public:
         nBits = 0;
         nNonce = uint256();
         nSolution.clear();
+        ClearHashCache();
     }
 
     bool IsNull() const
@@ -234,9 +269,29 @@ public:
     bool CheckNonCanonicalData() const;
     bool CheckNonCanonicalData(const uint160 &cID) const;
 
-    uint256 GetHash() const
+    // returns the hash of the header, which is only computed again if the header has changed since the last call
+    uint256 GetHash() const;
+
+    // records hash as the result of GetHash for the header's current contents, for callers such as the miner that
+    // have already computed it. the caller must be certain that it is the same hash that GetHash would compute.
+    void CacheHash(const uint256 &hash) const;
+
+    void ClearHashCache() const
     {
-        return (this->*hashFunction)();
+        std::atomic_store(&hashCache, std::shared_ptr<const CBlockHeaderHashCache>());
+    }
+
+    // true if all fields that are hashed match those of the other header
+    bool HashedDataEquals(const CBlockHeader &other) const
+    {
+        return nVersion == other.nVersion &&
+               hashPrevBlock == other.hashPrevBlock &&
+               hashMerkleRoot == other.hashMerkleRoot &&
+               hashFinalSaplingRoot == other.hashFinalSaplingRoot &&
+               nTime == other.nTime &&
+               nBits == other.nBits &&
+               nNonce == other.nNonce &&
+               nSolution == other.nSolution;
     }
 
     // return a node from this block header, including hash of merkle root and block hash as well as compact chain power, to put into an MMR
@@ -364,6 +419,11 @@ public:
         // we need to add the merkle root on the left
         return CMMRNodeBranch(CMMRNodeBranch::BRANCH_MMRBLAKE_NODE, 2, 1, std::vector<uint256>({GetBlockMMRRoot()}));
     }
+
+private:
+    // the last hash returned by GetHash, with a copy of the header it was computed from, so that fields which are
+    // changed directly or by deserialization never return a stale hash. shared between copies of the header.
+    mutable std::shared_ptr<const CBlockHeaderHashCache> hashCache;
 };
 
 // this class is used to address the type mismatch that existed between nodes, where block headers
@@ -446,16 +506,8 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        block.hashPrevBlock  = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.hashFinalSaplingRoot   = hashFinalSaplingRoot;
-        block.nTime          = nTime;
-        block.nBits          = nBits;
-        block.nNonce         = nNonce;
-        block.nSolution      = nSolution;
-        return block;
+        // copies the header fields and shares any hash already computed for them
+        return CBlockHeader(*this);
     }
 
     // Build the in-memory merkle tree for this block and return the merkle root.
@@ -279,6 +279,7 @@ CTransactionMap::CTransactionMap(const CTransaction &tx)
 void CTransaction::UpdateHash() const
 {
     *const_cast<uint256*>(&hash) = SerializeHash(*this);
+    std::atomic_store(&outputDescriptors, std::shared_ptr<const std::vector<CTxOutDescriptor>>());
 }
 
 CTransaction::CTransaction() : nVersion(CTransaction::SPROUT_MIN_CURRENT_VERSION), fOverwintered(false), nVersionGroupId(0), nExpiryHeight(0), vin(), vout(), nLockTime(0), valueBalance(0), vShieldedSpend(), vShieldedOutput(), vJoinSplit(), joinSplitPubKey(), joinSplitSig(), bindingSig() { }
@@ -315,6 +316,14 @@ CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), fO
     UpdateHash();
 }
 
+CTransaction::CTransaction(const CTransaction &tx) : nVersion(tx.nVersion), fOverwintered(tx.fOverwintered), nVersionGroupId(tx.nVersionGroupId), nExpiryHeight(tx.nExpiryHeight),
+                                                     vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime),
+                                                     valueBalance(tx.valueBalance), vShieldedSpend(tx.vShieldedSpend), vShieldedOutput(tx.vShieldedOutput),
+                                                     vJoinSplit(tx.vJoinSplit), joinSplitPubKey(tx.joinSplitPubKey), joinSplitSig(tx.joinSplitSig),
+                                                     bindingSig(tx.bindingSig), hash(tx.hash), outputDescriptors(std::atomic_load(&tx.outputDescriptors))
+{
+}
+
 CTransaction& CTransaction::operator=(const CTransaction &tx) {
     *const_cast<bool*>(&fOverwintered) = tx.fOverwintered;
     *const_cast<int*>(&nVersion) = tx.nVersion;
@@ -331,9 +340,32 @@ CTransaction& CTransaction::operator=(const CTransaction &tx) {
     *const_cast<joinsplit_sig_t*>(&joinSplitSig) = tx.joinSplitSig;
     *const_cast<binding_sig_t*>(&bindingSig) = tx.bindingSig;
     *const_cast<uint256*>(&hash) = tx.hash;
+    std::atomic_store(&outputDescriptors, std::atomic_load(&tx.outputDescriptors));
     return *this;
 }
 
+const CTxOutDescriptor &CTransaction::GetOutputDescriptor(int n) const
+{
+    std::shared_ptr<const std::vector<CTxOutDescriptor>> descriptors = std::atomic_load(&outputDescriptors);
+    if (!descriptors)
+    {
+        std::shared_ptr<std::vector<CTxOutDescriptor>> parsed = std::make_shared<std::vector<CTxOutDescriptor>>();
+        parsed->reserve(vout.size());
+        for (auto &oneOut : vout)
+        {
+            parsed->emplace_back(oneOut.scriptPubKey);
+        }
+        // if another thread got here first, callers may already hold references into its descriptors, so keep them
+        std::shared_ptr<const std::vector<CTxOutDescriptor>> expected;
+        descriptors = parsed;
+        if (!std::atomic_compare_exchange_strong(&outputDescriptors, &expected, descriptors))
+        {
+            descriptors = expected;
+        }
+    }
+    return (*descriptors)[n];
+}
+
 
 uint256 CTransaction::GetMMRRoot() const
 {
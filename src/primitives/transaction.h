@@ -24,6 +24,8 @@
 #endif
 
 #include <array>
+#include <memory>
+#include <typeinfo>
 
 #include <boost/variant.hpp>
 
@@ -508,6 +510,57 @@ static_assert(OVERWINTER_VERSION_GROUP_ID != 0, "version group id must be non-ze
 static constexpr uint32_t SAPLING_VERSION_GROUP_ID = 0x892F2085;
 static_assert(SAPLING_VERSION_GROUP_ID != 0, "version group id must be non-zero as specified in ZIP 202");
 
+/** An output script as parsed by CScript::IsPayToCryptoCondition(COptCCParams &), along with the last object decoded
+ *  from the first data element of its parameters. A transaction creates these once, on first use, and shares them with
+ *  its copies, so that validation, the mempool and the miner do not each reparse the same outputs.
+ */
+class CTxOutDescriptor
+{
+public:
+    struct CDecodedObject
+    {
+        const std::type_info *type;
+        std::shared_ptr<const void> object;
+        size_t nSize;                       // size of the object and of the data it was decoded from
+    };
+
+private:
+    mutable std::shared_ptr<const CDecodedObject> decoded;
+
+public:
+    bool isPayToCC;
+    COptCCParams p;
+
+    CTxOutDescriptor(const CScript &scriptPubKey) { isPayToCC = scriptPubKey.IsPayToCryptoCondition(p); }
+
+    // p.vData[0] decoded as TOBJ, or null if there is no data. objects are decoded with their vector constructors,
+    // so callers must still check IsValid().
+    template <typename TOBJ>
+    std::shared_ptr<const TOBJ> GetObject() const
+    {
+        if (p.vData.empty())
+        {
+            return nullptr;
+        }
+        std::shared_ptr<const CDecodedObject> cached = std::atomic_load(&decoded);
+        if (cached && *cached->type == typeid(TOBJ))
+        {
+            return std::static_pointer_cast<const TOBJ>(cached->object);
+        }
+        std::shared_ptr<const TOBJ> object = std::make_shared<const TOBJ>(p.vData[0]);
+        std::atomic_store(&decoded, std::shared_ptr<const CDecodedObject>(
+            std::make_shared<const CDecodedObject>(CDecodedObject({&typeid(TOBJ), object, sizeof(TOBJ) + p.vData[0].size()}))));
+        return object;
+    }
+
+    // the approximate size of the decoded object, which is type erased, or 0 if nothing was decoded
+    size_t DecodedSize() const
+    {
+        std::shared_ptr<const CDecodedObject> cached = std::atomic_load(&decoded);
+        return cached ? cached->nSize : 0;
+    }
+};
+
 struct CMutableTransaction;
 
 typedef CMerkleMountainRange<CDefaultMMRNode, CChunkedLayer<CDefaultMMRNode, 2>> TransactionMMRange;
@@ -521,6 +574,7 @@ class CTransaction
 private:
     /** Memory only. */
     const uint256 hash;
+    mutable std::shared_ptr<const std::vector<CTxOutDescriptor>> outputDescriptors;
     void UpdateHash() const;
 
 protected:
@@ -585,6 +639,7 @@ public:
     CTransaction(const CMutableTransaction &tx);
     CTransaction(CMutableTransaction &&tx);
 
+    CTransaction(const CTransaction &tx);
     CTransaction& operator=(const CTransaction& tx);
 
     ADD_SERIALIZE_METHODS;
@@ -664,6 +719,13 @@ public:
         return header;
     }
 
+    // output n parsed as a crypto-condition, which is only done once per transaction. the reference remains valid
+    // until the transaction is assigned to or deserialized into.
+    const CTxOutDescriptor &GetOutputDescriptor(int n) const;
+
+    // the output descriptors if any were built, which are shared with copies of this transaction
+    std::shared_ptr<const std::vector<CTxOutDescriptor>> GetOutputDescriptors() const { return std::atomic_load(&outputDescriptors); }
+
     // returns an MMR node for the block merkle mountain range
     TransactionMMRange GetTransactionMMR() const;
     CDefaultMMRNode GetDefaultMMRNode() const;
@@ -1166,11 +1166,13 @@ UniValue getblock(const UniValue& params, bool fHelp)
 
 UniValue gettxoutsetinfo(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() != 0)
+    if (fHelp || params.size() > 1)
         throw runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( full )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "The statistics are kept up to date as blocks are connected, and only a chainstate without them is scanned.\n"
+            "\nArguments:\n"
+            "1. full    (boolean, optional, default=false) Scan the whole set, which also returns its serialized hash\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
@@ -1178,26 +1180,45 @@ UniValue gettxoutsetinfo(const UniValue& params, bool fHelp)
             "  \"transactions\": n,      (numeric) The number of transactions\n"
             "  \"txouts\": n,            (numeric) The number of output transactions\n"
             "  \"bytes_serialized\": n,  (numeric) The serialized size\n"
-            "  \"hash_serialized\": \"hash\",   (string) The serialized hash\n"
+            "  \"hash_serialized\": \"hash\",   (string) The serialized hash, only when the set was scanned\n"
+            "  \"muhash\": \"hash\",            (string) The order independent MuHash3072 hash of the set\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
+            "  \"reserve_amounts\": {         (object) The total amount of each reserve currency held in outputs\n"
+            "    \"currencyid\": x.xxx\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "true")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
+    bool fFullScan = params.size() > 0 && params[0].get_bool();
+
     UniValue ret(UniValue::VOBJ);
 
     CCoinsStats stats;
     FlushStateToDisk();
-    if (pcoinsTip->GetStats(stats)) {
+    if (fFullScan ? pcoinsTip->ScanStats(stats) : pcoinsTip->GetStats(stats)) {
         ret.push_back(Pair("height", (int64_t)stats.nHeight));
         ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
         ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
         ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
         ret.push_back(Pair("bytes_serialized", (int64_t)stats.nSerializedSize));
-        ret.push_back(Pair("hash_serialized", stats.hashSerialized.GetHex()));
+        if (!stats.hashSerialized.IsNull())
+            ret.push_back(Pair("hash_serialized", stats.hashSerialized.GetHex()));
+        if (!stats.hashMuHash.IsNull())
+            ret.push_back(Pair("muhash", stats.hashMuHash.GetHex()));
         ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
+        if (stats.reserveAmounts.valueMap.size())
+        {
+            UniValue reserveAmounts(UniValue::VOBJ);
+            for (auto &oneAmount : stats.reserveAmounts.valueMap)
+            {
+                reserveAmounts.push_back(Pair(EncodeDestination(CIdentityID(oneAmount.first)), ValueFromAmount(oneAmount.second)));
+            }
+            ret.push_back(Pair("reserve_amounts", reserveAmounts));
+        }
     }
     return ret;
 }
@@ -1715,6 +1736,13 @@ UniValue getblockchaininfo(const UniValue& params, bool fHelp)
             "  \"consensus\": {               (object) branch IDs of the current and upcoming consensus rules\n"
             "     \"chaintip\": \"xxxxxxxx\",   (string) branch ID used to validate the current chain tip\n"
             "     \"nextblock\": \"xxxxxxxx\"   (string) branch ID that the next block will be validated under\n"
+            "  },\n"
+            "  \"txcache\": {                 (object) cache of transactions read from blocks through the transaction index\n"
+            "     \"hits\": xxxxxx,           (numeric) lookups answered from the cache\n"
+            "     \"misses\": xxxxxx,         (numeric) lookups that were not in the cache\n"
+            "     \"evictions\": xxxxxx,      (numeric) transactions evicted to stay within the cache size\n"
+            "     \"entries\": xxxxxx,        (numeric) transactions currently cached\n"
+            "     \"bytes\": xxxxxx           (numeric) approximate memory used by cached transactions\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -1775,6 +1803,15 @@ UniValue getblockchaininfo(const UniValue& params, bool fHelp)
     consensus.push_back(Pair("nextblock", HexInt(CurrentEpochBranchId(tip->GetHeight() + 1, consensusParams))));
     obj.push_back(Pair("consensus", consensus));
 
+    CTransactionCache::CStats txCacheStats = GetTransactionCacheStats();
+    UniValue txCache(UniValue::VOBJ);
+    txCache.push_back(Pair("hits", txCacheStats.hits));
+    txCache.push_back(Pair("misses", txCacheStats.misses));
+    txCache.push_back(Pair("evictions", txCacheStats.evictions));
+    txCache.push_back(Pair("entries", (uint64_t)txCacheStats.entries));
+    txCache.push_back(Pair("bytes", (uint64_t)txCacheStats.usedBytes));
+    obj.push_back(Pair("txcache", txCache));
+
     if (fPruneMode)
     {
         CBlockIndex *block = chainActive.LastTip();
@@ -1903,6 +1940,9 @@ UniValue mempoolInfoToJSON()
     ret.push_back(Pair("size", (int64_t) mempool.size()));
     ret.push_back(Pair("bytes", (int64_t) mempool.GetTotalTxSize()));
     ret.push_back(Pair("usage", (int64_t) mempool.DynamicMemoryUsage()));
+    size_t maxmempool = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    ret.push_back(Pair("maxmempool", (int64_t) maxmempool));
+    ret.push_back(Pair("mempoolminfee", ValueFromAmount(mempool.GetMinFee(maxmempool).GetFeePerK())));
 
     if (Params().NetworkIDString() == "regtest") {
         ret.push_back(Pair("fullyNotified", mempool.IsFullyNotified()));
@@ -1922,6 +1962,8 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp)
             "  \"size\": xxxxx                (numeric) Current tx count\n"
             "  \"bytes\": xxxxx               (numeric) Sum of all tx sizes\n"
             "  \"usage\": xxxxx               (numeric) Total memory usage for the mempool\n"
+            "  \"maxmempool\": xxxxx          (numeric) Maximum memory usage for the mempool\n"
+            "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee per kB for a transaction to be accepted\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -1690,6 +1690,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "sendrawtransaction", 1 },
     { "fundrawtransaction", 1 },
     { "estimateconversion", 0 },
+    { "gettxoutsetinfo", 0 },
     { "gettxout", 1 },
     { "gettxout", 2 },
     { "gettxoutproof", 0 },
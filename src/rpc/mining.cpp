@@ -395,6 +395,10 @@ UniValue getmininginfo(const UniValue& params, bool fHelp)
             "  \"blocks\": nnn,             (numeric) The current block\n"
             "  \"currentblocksize\": nnn,   (numeric) The last block size\n"
             "  \"currentblocktx\": nnn,     (numeric) The last block transaction\n"
+            "  \"currentblockfees\": xxx.xxxxx (numeric) The fees of the transactions in the last block template\n"
+            "  \"currentblockfeerate\": xxx.xxxxx (numeric) The fees per kB of the transactions in the last block template\n"
+            "  \"currentblockassemblyms\": xxx.xx (numeric) Milliseconds taken to assemble the last block template\n"
+            "  \"currentblockscannedtx\": nnn, (numeric) Mempool transactions whose inputs were looked up for the last block template, others were cached from the template before it\n"
             "  \"averageblockfees\": xxx.xxxxx (numeric) The average block fees, in addition to block reward, over the past 100 blocks\n"
             "  \"difficulty\": xxx.xxxxx    (numeric) The current difficulty\n"
             "  \"stakingsupply\": xxx.xxxxx (numeric) The current estimated total staking supply\n"
@@ -501,6 +505,10 @@ UniValue getmininginfo(const UniValue& params, bool fHelp)
     obj.push_back(Pair("blocks",           (int)height));
     obj.push_back(Pair("currentblocksize", (uint64_t)nLastBlockSize));
     obj.push_back(Pair("currentblocktx",   (uint64_t)nLastBlockTx));
+    obj.push_back(Pair("currentblockfees", ValueFromAmount(nLastBlockFees)));
+    obj.push_back(Pair("currentblockfeerate", ValueFromAmount(CFeeRate(nLastBlockFees, nLastBlockSize).GetFeePerK())));
+    obj.push_back(Pair("currentblockassemblyms", 0.001 * nLastBlockAssemblyTime));
+    obj.push_back(Pair("currentblockscannedtx", (uint64_t)nLastBlockScannedTx));
     obj.push_back(Pair("averageblockfees", ValueFromAmount(avgBlockFees)));
     obj.push_back(Pair("difficulty",       (double)GetNetworkDifficulty()));
     if (!estimatedStakingSupply && totalChainStake != 0)
@@ -675,6 +683,224 @@ UniValue getminingdistribution(const UniValue& params, bool fHelp)
     return distributionObj;
 }
 
+// a block template and the chain and mempool state it was built from
+struct CBlockTemplateSlot
+{
+    CBlockIndex *pindexPrev;
+    int64_t nStart;
+    unsigned int nTransactionsUpdated;
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+
+    CBlockTemplateSlot() : pindexPrev(NULL), nStart(0), nTransactionsUpdated(0) {}
+};
+
+// block templates shared by getblocktemplate callers with the same coinbase and by the template publisher, keyed by
+// their coinbase parameters and guarded by cs_main. the long poll id of the newest template is also written under
+// csBestBlock, so long poll waiters can watch it without cs_main.
+static std::map<std::string, CBlockTemplateSlot> mapBlockTemplates;
+static std::string strTemplateLongPollId;
+static int nLongPollWaiters;
+
+// at most this many templates are kept for the current tip, besides the published one
+static const int MAX_BLOCK_TEMPLATE_SLOTS = 8;
+
+// a long poll returns for mempool changes once the template it was given is this old
+static const int64_t LONGPOLL_MEMPOOL_MILLIS = 60000;
+
+// the coinbase of a template pays either a mining distribution, which is the configured one unless the request has
+// its own, or the wallet, and may commit to a nonce. returns a key that is equal for requests with the same coinbase.
+static std::string BlockTemplateCoinbaseKey(const UniValue& params, UniValue& recipientWeights, uint256& useNonce)
+{
+    recipientWeights = UniValue();
+    useNonce = uint256();
+    if (params.size() > 0)
+    {
+        useNonce = uint256S(uni_get_str(find_value(params[0], "nonce")));
+        if (!(recipientWeights = find_value(params[0], "miningdistribution")).isObject())
+        {
+            recipientWeights = getminingdistribution(UniValue(UniValue::VARR), false);
+        }
+        if (!recipientWeights.isObject() || !recipientWeights.getKeys().size())
+        {
+            recipientWeights = UniValue();
+        }
+    }
+    return (recipientWeights.isNull() ? std::string() : recipientWeights.write()) + "/" + useNonce.GetHex();
+}
+
+// the template that ThreadBlockTemplates keeps up to date and publishes is built as for a request without options
+static UniValue PublishedTemplateParams()
+{
+    UniValue params(UniValue::VARR);
+    params.push_back(UniValue(UniValue::VOBJ));
+    return params;
+}
+
+// rebuilds the template for the coinbase that params ask for when the tip has changed, or when the mempool has changed
+// and the template is older than nRefreshMillis, then wakes the long poll waiters and publishes it if it is the
+// published one. the returned slot is valid until cs_main is released.
+static const CBlockTemplateSlot &UpdateBlockTemplate(const UniValue& params, int64_t nRefreshMillis)
+{
+    AssertLockHeld(cs_main);
+
+    UniValue recipientWeights, publishedWeights;
+    uint256 useNonce, publishedNonce;
+    std::string strKey = BlockTemplateCoinbaseKey(params, recipientWeights, useNonce);
+    std::string strPublishedKey = BlockTemplateCoinbaseKey(PublishedTemplateParams(), publishedWeights, publishedNonce);
+
+    // templates for the same tip reuse the previous mempool scan, so they can follow the mempool closely
+    CBlockTemplateSlot &slot = mapBlockTemplates[strKey];
+    if (slot.pindexPrev == chainActive.LastTip() &&
+        (mempool.GetTransactionsUpdated() == slot.nTransactionsUpdated || GetTimeMillis() - slot.nStart <= nRefreshMillis))
+    {
+        return slot;
+    }
+
+    // Clear pindexPrev so future calls make a new block, despite any failures from here on
+    slot.pindexPrev = NULL;
+
+    // Store the pindexBest used before CreateNewBlockWithKey, to avoid races
+    slot.nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    CBlockIndex* pindexPrevNew = chainActive.LastTip();
+    slot.nStart = GetTimeMillis();
+
+    // Create new block
+    slot.pblocktemplate.reset();
+
+    if (!recipientWeights.isNull())
+    {
+        std::vector<CTxOut> minerOutputs;
+        auto rewardAddresses = recipientWeights.getKeys();
+        for (int i = 0; i < rewardAddresses.size(); i++)
+        {
+            CTxDestination oneDest = DecodeDestination(rewardAddresses[i]);
+            CAmount relVal = 0;
+            if (oneDest.which() == COptCCParams::ADDRTYPE_INVALID ||
+                !(relVal = AmountFromValue(find_value(recipientWeights, rewardAddresses[i]))))
+            {
+                throw JSONRPCError(RPC_INVALID_PARAMS, "Invalid destination or zero weight specified in miningdistribution array");
+            }
+            minerOutputs.push_back(CTxOut(relVal, GetScriptForDestination(oneDest)));
+        }
+        slot.pblocktemplate.reset(CreateNewBlock(Params(), minerOutputs, false, useNonce));
+    }
+    else
+    {
+        CReserveKey reservekey(pwalletMain);
+        slot.pblocktemplate.reset(CreateNewBlockWithKey(reservekey, chainActive.LastTip()->GetHeight()+1, false, useNonce));
+    }
+
+    /* keep Zcash script-based approach for reference
+    boost::shared_ptr<CReserveScript> coinbaseScript;
+    GetMainSignals().ScriptForMining(coinbaseScript);
+
+    // Throw an error if no script was provided
+    if (!coinbaseScript->reserveScript.size())
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "No coinbase script available (mining requires a wallet or -mineraddress)");
+
+    pblocktemplate = CreateNewBlock(Params(), coinbaseScript->reserveScript);
+    */
+
+    if (!slot.pblocktemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory or no available utxo for staking");
+
+    // Mark script as important because it was used at least for one coinbase output
+    //coinbaseScript->KeepScript();
+
+    // Need to update only after we know CreateNewBlock succeeded
+    slot.pindexPrev = pindexPrevNew;
+
+    // other templates are dropped once the tip moves on, and the oldest go first when there are too many
+    for (auto it = mapBlockTemplates.begin(); it != mapBlockTemplates.end(); )
+    {
+        if (it->first != strKey && it->first != strPublishedKey && it->second.pindexPrev != pindexPrevNew)
+        {
+            it = mapBlockTemplates.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    while (mapBlockTemplates.size() > MAX_BLOCK_TEMPLATE_SLOTS + 1)
+    {
+        auto oldest = mapBlockTemplates.end();
+        for (auto it = mapBlockTemplates.begin(); it != mapBlockTemplates.end(); it++)
+        {
+            if (it->first != strKey && it->first != strPublishedKey &&
+                (oldest == mapBlockTemplates.end() || it->second.nStart < oldest->second.nStart))
+            {
+                oldest = it;
+            }
+        }
+        mapBlockTemplates.erase(oldest);
+    }
+
+    // every waiting long poll returns a template for the newest state, rather than each building its own. the id only
+    // depends on the tip and the mempool, so a template rebuilt for another coinbase for the same state wakes no one.
+    std::string strLongPollId = pindexPrevNew->GetBlockHash().GetHex() + i64tostr(slot.nTransactionsUpdated);
+    bool fNewState;
+    {
+        boost::unique_lock<boost::mutex> lock(csBestBlock);
+        fNewState = strTemplateLongPollId != strLongPollId;
+        strTemplateLongPollId = strLongPollId;
+    }
+    if (fNewState)
+    {
+        cvBlockChange.notify_all();
+    }
+
+    if (strKey == strPublishedKey)
+    {
+        GetMainSignals().UpdatedBlockTemplate(slot.pblocktemplate->block);
+    }
+    return slot;
+}
+
+// builds the published template as soon as the tip changes, and for mempool changes at the long poll interval, while
+// there are long poll waiters or templates are published
+void ThreadBlockTemplates()
+{
+    bool fPublish = !GetArg("-zmqpubblocktemplate", "").empty();
+
+    while (true)
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(csBestBlock);
+            cvBlockChange.timed_wait(lock, boost::get_system_time() + boost::posix_time::seconds(10));
+            if (!nLongPollWaiters && !fPublish)
+                continue;
+        }
+        boost::this_thread::interruption_point();
+
+        // the same requirements as getblocktemplate, without the errors
+        if (GetArg("-mineraddress", "").empty() && !pwalletMain)
+            continue;
+        {
+            LOCK(cs_vNodes);
+            if (Params().MiningRequiresPeers() && vNodes.empty())
+                continue;
+        }
+
+        LOCK(cs_main);
+        if (!chainActive.LastTip() || (Params().MiningRequiresPeers() && IsNotInSync()))
+            continue;
+        // only rebuilds for tip and mempool changes, since templates for other coinbases have their own slots
+        try
+        {
+            UpdateBlockTemplate(PublishedTemplateParams(), LONGPOLL_MEMPOOL_MILLIS);
+        }
+        catch (const UniValue& objError)
+        {
+            LogPrint("rpc", "%s: %s\n", __func__, find_value(objError, "message").get_str());
+        }
+        catch (const std::exception& e)
+        {
+            LogPrintf("%s: %s\n", __func__, e.what());
+        }
+    }
+}
+
 UniValue getblocktemplate(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() > 1)
@@ -827,46 +1053,38 @@ UniValue getblocktemplate(const UniValue& params, bool fHelp)
     //if (IsInitialBlockDownload())
     //   throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Zcash is downloading blocks...");
 
-    static unsigned int nTransactionsUpdatedLast;
-
     if (!lpval.isNull())
     {
-        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions
+        // Wait to respond until either the best block changes, OR a newer template is built. for mempool changes,
+        // that is done by ThreadBlockTemplates once the last template is a minute old
         uint256 hashWatchedChain;
-        boost::system_time checktxtime;
-        unsigned int nTransactionsUpdatedLastLP;
+        std::string strLongPollId;
 
         if (lpval.isStr())
         {
             // Format: <hashBestChain><nTransactionsUpdatedLast>
-            std::string lpstr = lpval.get_str();
-
-            hashWatchedChain.SetHex(lpstr.substr(0, 64));
-            nTransactionsUpdatedLastLP = atoi64(lpstr.substr(64));
+            strLongPollId = lpval.get_str();
+            hashWatchedChain.SetHex(strLongPollId.substr(0, 64));
         }
         else
         {
             // NOTE: Spec does not specify behaviour for non-string longpollid, but this makes testing easier
             hashWatchedChain = chainActive.LastTip()->GetBlockHash();
-            nTransactionsUpdatedLastLP = nTransactionsUpdatedLast;
+            strLongPollId = strTemplateLongPollId;
         }
 
         // Release the wallet and main lock while waiting
         LEAVE_CRITICAL_SECTION(cs_main);
         {
-            checktxtime = boost::get_system_time() + boost::posix_time::minutes(1);
-
             boost::unique_lock<boost::mutex> lock(csBestBlock);
-            while (chainActive.LastTip()->GetBlockHash() == hashWatchedChain && IsRPCRunning())
+            nLongPollWaiters++;
+            while (chainActive.LastTip()->GetBlockHash() == hashWatchedChain &&
+                   strTemplateLongPollId == strLongPollId &&
+                   IsRPCRunning())
             {
-                if (!cvBlockChange.timed_wait(lock, checktxtime))
-                {
-                    // Timeout: Check transactions for update
-                    if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
-                        break;
-                    checktxtime += boost::posix_time::seconds(10);
-                }
+                cvBlockChange.timed_wait(lock, boost::get_system_time() + boost::posix_time::seconds(10));
             }
+            nLongPollWaiters--;
         }
         ENTER_CRITICAL_SECTION(cs_main);
 
@@ -876,80 +1094,9 @@ UniValue getblocktemplate(const UniValue& params, bool fHelp)
     }
 
     // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static CBlockTemplate* pblocktemplate;
-    if (pindexPrev != chainActive.LastTip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = NULL;
-
-        // Store the pindexBest used before CreateNewBlockWithKey, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.LastTip();
-        nStart = GetTime();
-
-        // Create new block
-        if(pblocktemplate)
-        {
-            delete pblocktemplate;
-            pblocktemplate = NULL;
-        }
-
-        uint256 useNonce;
-        if (params.size() > 0)
-        {
-            useNonce = uint256S(uni_get_str(find_value(params[0], "nonce")));
-        }
-
-        UniValue recipientWeights;
-        if (params.size() > 0 &&
-            ((recipientWeights = find_value(params[0], "miningdistribution")).isObject() ||
-             (recipientWeights = getminingdistribution(UniValue(UniValue::VARR), false)).isObject()) &&
-            recipientWeights.getKeys().size())
-        {
-            std::vector<CTxOut> minerOutputs;
-            auto rewardAddresses = recipientWeights.getKeys();
-            for (int i = 0; i < rewardAddresses.size(); i++)
-            {
-                CTxDestination oneDest = DecodeDestination(rewardAddresses[i]);
-                CAmount relVal = 0;
-                if (oneDest.which() == COptCCParams::ADDRTYPE_INVALID ||
-                    !(relVal = AmountFromValue(find_value(recipientWeights, rewardAddresses[i]))))
-                {
-                    throw JSONRPCError(RPC_INVALID_PARAMS, "Invalid destination or zero weight specified in miningdistribution array");
-                }
-                minerOutputs.push_back(CTxOut(relVal, GetScriptForDestination(oneDest)));
-            }
-            pblocktemplate = CreateNewBlock(Params(), minerOutputs, false, useNonce);
-        }
-        else
-        {
-            CReserveKey reservekey(pwalletMain);
-            pblocktemplate = CreateNewBlockWithKey(reservekey, chainActive.LastTip()->GetHeight()+1, false, useNonce);
-        }
-
-        /* keep Zcash script-based approach for reference
-        boost::shared_ptr<CReserveScript> coinbaseScript;
-        GetMainSignals().ScriptForMining(coinbaseScript);
-
-        // Throw an error if no script was provided
-        if (!coinbaseScript->reserveScript.size())
-            throw JSONRPCError(RPC_INTERNAL_ERROR, "No coinbase script available (mining requires a wallet or -mineraddress)");
-
-        pblocktemplate = CreateNewBlock(Params(), coinbaseScript->reserveScript);
-        */
-
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory or no available utxo for staking");
-
-        // Mark script as important because it was used at least for one coinbase output
-        //coinbaseScript->KeepScript();
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
-    }
+    const CBlockTemplateSlot &templateSlot = UpdateBlockTemplate(params, 1000);
+    CBlockIndex* pindexPrev = templateSlot.pindexPrev;
+    CBlockTemplate* pblocktemplate = templateSlot.pblocktemplate.get();
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
 
     int64_t Mining_height = (int64_t)(pindexPrev->GetHeight()+1);
@@ -1043,7 +1190,7 @@ UniValue getblocktemplate(const UniValue& params, bool fHelp)
         result.push_back(Pair("coinbaseaux", aux));
         result.push_back(Pair("coinbasevalue", (int64_t)pblock->vtx[0].vout[0].nValue));
     }
-    result.push_back(Pair("longpollid", chainActive.LastTip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast)));
+    result.push_back(Pair("longpollid", strTemplateLongPollId));
     if ( ASSETCHAINS_STAKED != 0 )
     {
         arith_uint256 POWtarget; int32_t PoSperc;
@@ -61,7 +61,7 @@ extern uint64_t KOMODO_INTERESTSUM,KOMODO_WALLETBALANCE;
 extern int32_t KOMODO_LASTMINED,JUMBLR_PAUSE,KOMODO_LONGESTCHAIN;
 extern char ASSETCHAINS_SYMBOL[KOMODO_ASSETCHAIN_MAXLEN];
 uint32_t komodo_segid32(char *coinaddr);
-bool GetCoinSupply(int64_t &transparentSupply, int64_t *pzsupply, int64_t *pimmaturesupply, uint32_t height);
+bool GetCoinSupply(int64_t &transparentSupply, int64_t *pzsupply, int64_t *pimmaturesupply, uint32_t height, CCurrencyValueMap *pcurrencysupply=nullptr);
 int32_t notarizedtxid_height(char *dest,char *txidstr,int32_t *kmdnotarized_heightp);
 
 extern uint16_t ASSETCHAINS_P2PPORT,ASSETCHAINS_RPCPORT;
@@ -360,6 +360,7 @@ UniValue coinsupply(const UniValue& params, bool fHelp)
     if (fHelp || params.size() > 1)
         throw runtime_error("coinsupply <height>\n"
             "\nReturn coin supply information at a given block height. If no height is given, the current height is used.\n"
+            "The supply is stored in the block index, and only blocks that have not been recorded there yet are read.\n"
             "\nArguments:\n"
             "1. \"height\"     (integer, optional) Block height\n"
             "\nResult:\n"
@@ -368,8 +369,12 @@ UniValue coinsupply(const UniValue& params, bool fHelp)
             "  \"coin\" : \"VRSC\",              (string) The currency symbol of the native coin of this blockchain.\n"
             "  \"height\" : 420,                 (integer) The height of this coin supply data\n"
             "  \"supply\" : \"777.0\",           (float) The transparent coin supply\n"
+            "  \"immature\" : \"7.0\",           (float) The part of the transparent supply in coinbase outputs that have not matured\n"
             "  \"zfunds\" : \"0.777\",           (float) The shielded coin supply (in zaddrs)\n"
             "  \"total\" :  \"777.777\",         (float) The total coin supply, i.e. sum of supply + zfunds\n"
+            "  \"currencies\" : {                (object, optional) Net amount of each other currency in transparent outputs, as issued by imports\n"
+            "    \"currencyid\" : x.xxx\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("coinsupply", "420")
@@ -378,6 +383,7 @@ UniValue coinsupply(const UniValue& params, bool fHelp)
 
     uint32_t height = 0;
     int64_t zfunds = 0, supply = 0, immature = 0;
+    CCurrencyValueMap currencySupply;
     UniValue result(UniValue::VOBJ);
 
     if ( params.size() == 0 )
@@ -385,7 +391,7 @@ UniValue coinsupply(const UniValue& params, bool fHelp)
     else height = atoi(uni_get_str(params[0]));
 
     if (height > 0 && height <= chainActive.Height()) {
-        if (GetCoinSupply(supply, &zfunds, &immature, height))
+        if (GetCoinSupply(supply, &zfunds, &immature, height, &currencySupply))
         {
             result.push_back(Pair("result", "success"));
             result.push_back(Pair("coin", ASSETCHAINS_SYMBOL[0] == 0 ? "KMD" : ASSETCHAINS_SYMBOL));
@@ -394,6 +400,15 @@ UniValue coinsupply(const UniValue& params, bool fHelp)
             result.push_back(Pair("immature", ValueFromAmount(immature)));
             result.push_back(Pair("zfunds", ValueFromAmount(zfunds)));
             result.push_back(Pair("total", ValueFromAmount(zfunds + supply)));
+            if (currencySupply.valueMap.size())
+            {
+                UniValue currencies(UniValue::VOBJ);
+                for (auto &oneSupply : currencySupply.valueMap)
+                {
+                    currencies.push_back(Pair(EncodeDestination(CIdentityID(oneSupply.first)), ValueFromAmount(oneSupply.second)));
+                }
+                result.push_back(Pair("currencies", currencies));
+            }
         } else result.push_back(Pair("error", "couldnt calculate supply"));
     } else {
         result.push_back(Pair("error", "invalid height"));
@@ -1748,6 +1763,88 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+// paged address index queries return a cursor, which is the position in the address list and the last index key returned
+template <typename KEY>
+static std::string EncodeAddressCursor(uint32_t addressNum, const KEY &lastKey)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << addressNum << lastKey;
+    return HexStr(ss.begin(), ss.end());
+}
+
+// reads "limit" and "cursor" from the parameters of a paged address index query and returns the limit, which is 0 if the
+// results are not paged. haveKey is false if the query starts at the beginning of address addressNum.
+template <typename KEY>
+static size_t GetAddressPageParams(const UniValue &params, size_t numAddresses, uint32_t &addressNum, KEY &lastKey, bool &haveKey)
+{
+    addressNum = 0;
+    haveKey = false;
+    if (!params[0].isObject())
+    {
+        return 0;
+    }
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    int64_t limit = limitValue.isNull() ? 0 : uni_get_int64(limitValue);
+    if (limit < 0)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit must not be negative");
+    }
+    if (!cursorValue.isNull())
+    {
+        if (!limit)
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "A cursor requires a limit");
+        }
+        std::string cursorStr = uni_get_str(cursorValue);
+        if (!IsHex(cursorStr))
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        std::vector<unsigned char> cursorBytes = ParseHex(cursorStr);
+        CDataStream ss(cursorBytes, SER_DISK, CLIENT_VERSION);
+        try
+        {
+            ss >> addressNum >> lastKey;
+        }
+        catch (const std::exception &e)
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        if (!ss.empty() || addressNum >= numAddresses)
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        haveKey = true;
+    }
+    return limit;
+}
+
+// reads up to limit entries for the addresses from the cursor position with readPage, and returns the cursor for the next
+// page, or an empty string if there are no more. the index is read without holding cs_main.
+template <typename ENTRY, typename READPAGE>
+static std::string ReadAddressPages(const std::vector<std::pair<uint160, int>> &addresses,
+                                    uint32_t addressNum,
+                                    const typename ENTRY::first_type *after,
+                                    size_t limit,
+                                    std::vector<ENTRY> &entries,
+                                    READPAGE readPage)
+{
+    for (; addressNum < addresses.size(); addressNum++, after = nullptr)
+    {
+        if (!readPage(addresses[addressNum].first, addresses[addressNum].second, after, limit - entries.size(), entries))
+        {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        if (entries.size() >= limit)
+        {
+            return EncodeAddressCursor(addressNum, entries.back().first);
+        }
+    }
+    return "";
+}
+
 
 void CurrencyValuesAndNames(UniValue &output, bool spending, const CScript &script, CAmount satoshis, bool friendlyNames=false);
 void CurrencyValuesAndNames(UniValue &output, bool spending, const CScript &script, CAmount satoshis, bool friendlyNames)
@@ -2039,6 +2136,8 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
             "  \"chaininfo\"    (boolean) Include chain info with results\n"
             "  \"friendlynames\" (boolean, optional default=false) Include additional array of friendly names keyed by currency i-addresses\n"
             "  \"verbosity\"    (number) (default == 0), if 1, include output information for spends, including all reserve amounts and destinations\n"
+            "  \"limit\"        (number, optional) Return at most this many outputs, ordered by address and then txid, with a cursor for the rest\n"
+            "  \"cursor\"       (string, optional) The \"next\" value of the previous page, to continue a paged query\n"
             "}\n"
             "\nResult\n"
             "[\n"
@@ -2051,6 +2150,11 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
             "    \"satoshis\"  (number) The number of satoshis of the output\n"
             "  }\n"
             "]\n"
+            "\nResult with a limit\n"
+            "{\n"
+            "  \"utxos\" : [...]  (array) Outputs as above\n"
+            "  \"next\"  : \"hex\"  (string) Cursor for the next page, if there may be more outputs\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}")
@@ -2065,17 +2169,30 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    LOCK(cs_main);
+    uint32_t addressNum;
+    CAddressUnspentKey lastKey;
+    bool haveKey;
+    size_t limit = GetAddressPageParams(params, addresses.size(), addressNum, lastKey, haveKey);
 
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    std::string nextCursor;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    // without a limit, cs_main is held from the read through the chain info, so they describe the same tip
+    CCriticalBlock unpagedLock(limit ? nullptr : &cs_main, "cs_main", __FILE__, __LINE__);
+
+    if (limit) {
+        nextCursor = ReadAddressPages(addresses, addressNum, haveKey ? &lastKey : nullptr, limit, unspentOutputs, GetAddressUnspentPage);
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
         }
+
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
     }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    LOCK(cs_main);
 
     UniValue utxos(UniValue::VARR);
 
@@ -2130,9 +2247,15 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
         utxos.push_back(output);
     }
 
-    if (includeChainInfo) {
+    if (includeChainInfo || limit) {
         UniValue result(UniValue::VOBJ);
         result.push_back(Pair("utxos", utxos));
+        if (!nextCursor.empty()) {
+            result.push_back(Pair("next", nextCursor));
+        }
+        if (!includeChainInfo) {
+            return result;
+        }
 
         LOCK(cs_main);
         result.push_back(Pair("hash", chainActive.LastTip()->GetBlockHash().GetHex()));
@@ -2161,6 +2284,8 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
             "  \"chaininfo\" (boolean) Include chain info in results, only applies if start and end specified\n"
             "  \"friendlynames\" (boolean) Include additional array of friendly names keyed by currency i-addresses\n"
             "  \"verbosity\" (number) (default == 0), if 1, include output information for spends, including all reserve amounts and destinations\n"
+            "  \"limit\" (number, optional) Return at most this many deltas, with a cursor for the rest\n"
+            "  \"cursor\" (string, optional) The \"next\" value of the previous page, to continue a paged query\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -2172,6 +2297,11 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult with a limit:\n"
+            "{\n"
+            "  \"deltas\" : [...]  (array) Deltas as above\n"
+            "  \"next\"   : \"hex\"  (string) Cursor for the next page, if there may be more deltas\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}")
@@ -2205,10 +2335,23 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    uint32_t addressNum;
+    CAddressIndexKey lastKey;
+    bool haveKey;
+    size_t limit = GetAddressPageParams(params, addresses.size(), addressNum, lastKey, haveKey);
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::string nextCursor;
 
-    {
-        LOCK(cs_main);
+    // without a limit, cs_main is held from the read through the chain info, so they describe the same tip
+    CCriticalBlock unpagedLock(limit ? nullptr : &cs_main, "cs_main", __FILE__, __LINE__);
+
+    if (limit) {
+        nextCursor = ReadAddressPages(addresses, addressNum, haveKey ? &lastKey : nullptr, limit, addressIndex,
+            [start, end](const uint160 &addressHash, int type, const CAddressIndexKey *after, size_t maxEntries, std::vector<CAddressIndexDbEntry> &entries) {
+                return GetAddressIndexPage(addressHash, type, after, maxEntries, entries, start, end);
+            });
+    } else {
         for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
             if (start > 0 && end > 0) {
                 if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
@@ -2283,9 +2426,18 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
         endInfo.push_back(Pair("height", end));
 
         result.push_back(Pair("deltas", deltas));
+        if (!nextCursor.empty()) {
+            result.push_back(Pair("next", nextCursor));
+        }
         result.push_back(Pair("start", startInfo));
         result.push_back(Pair("end", endInfo));
 
+        return result;
+    } else if (limit) {
+        result.push_back(Pair("deltas", deltas));
+        if (!nextCursor.empty()) {
+            result.push_back(Pair("next", nextCursor));
+        }
         return result;
     } else {
         return deltas;
@@ -2298,6 +2450,7 @@ UniValue getaddressbalance(const UniValue& params, bool fHelp)
         throw runtime_error(
             "getaddressbalance\n"
             "\nReturns the balance for an address(es) (requires addressindex to be enabled).\n"
+            "With -balanceindex, the current balance is read from the index instead of summing the address history.\n"
             "\nArguments:\n"
             "{\n"
             "  \"addresses\"\n"
@@ -2329,20 +2482,32 @@ UniValue getaddressbalance(const UniValue& params, bool fHelp)
 
     LOCK2(cs_main, mempool.cs);
 
+    CAmount balance = 0;
+    CAmount received = 0;
+
+    CCurrencyValueMap reserveBalance;
+    CCurrencyValueMap reserveReceived;
+
+    // the balance index holds the totals of all of an address's history, so it answers unless a height is given
+    bool useBalanceIndex = fBalanceIndex && asOfBlock <= 0;
+
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex, 0, asOfBlock)) {
+        if (useBalanceIndex) {
+            CAddressBalanceValue addressBalance;
+            if (!GetAddressBalance((*it).first, (*it).second, addressBalance)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            balance += addressBalance.balance;
+            received += addressBalance.received;
+            reserveBalance += addressBalance.reserveBalance;
+            reserveReceived += addressBalance.reserveReceived;
+        } else if (!GetAddressIndex((*it).first, (*it).second, addressIndex, 0, asOfBlock)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
 
     CTransaction curTx;
 
-    CAmount balance = 0;
-    CAmount received = 0;
-
-    CCurrencyValueMap reserveBalance;
-    CCurrencyValueMap reserveReceived;
-
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
         uint256 blockHash;
         if (!it->first.txhash.IsNull() && (it->first.txhash == curTx.GetHash() || myGetTransaction(it->first.txhash, curTx, blockHash)))
@@ -2485,12 +2650,19 @@ UniValue getaddresstxids(const UniValue& params, bool fHelp)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Read at most this many index entries, ordered by address and then height, with a cursor for the rest\n"
+            "  \"cursor\" (string, optional) The \"next\" value of the previous page, to continue a paged query\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult with a limit:\n"
+            "{\n"
+            "  \"txids\" : [...]  (array) Transaction ids as above, which may repeat across pages\n"
+            "  \"next\"  : \"hex\"  (string) Cursor for the next page, if there may be more transactions\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"]}")
@@ -2513,8 +2685,36 @@ UniValue getaddresstxids(const UniValue& params, bool fHelp)
         }
     }
 
+    uint32_t addressNum;
+    CAddressIndexKey lastKey;
+    bool haveKey;
+    size_t limit = GetAddressPageParams(params, addresses.size(), addressNum, lastKey, haveKey);
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
+    if (limit) {
+        std::string nextCursor = ReadAddressPages(addresses, addressNum, haveKey ? &lastKey : nullptr, limit, addressIndex,
+            [start, end](const uint160 &addressHash, int type, const CAddressIndexKey *after, size_t maxEntries, std::vector<CAddressIndexDbEntry> &entries) {
+                return GetAddressIndexPage(addressHash, type, after, maxEntries, entries, start, end);
+            });
+
+        // entries of a page are in index order, so only duplicates within a page are removed
+        std::set<uint256> pageTxids;
+        UniValue txidsUni(UniValue::VARR);
+        for (auto &oneEntry : addressIndex) {
+            if (pageTxids.insert(oneEntry.first.txhash).second) {
+                txidsUni.push_back(oneEntry.first.txhash.GetHex());
+            }
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("txids", txidsUni));
+        if (!nextCursor.empty()) {
+            result.push_back(Pair("next", nextCursor));
+        }
+        return result;
+    }
+
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
         if (start > 0 && end > 0) {
             if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
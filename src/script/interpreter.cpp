@@ -1777,8 +1777,8 @@ int TransactionSignatureChecker::CheckCryptoCondition(
     };
 
     //fprintf(stderr,"non-checker path\n");
-    out = cc_verify(cond, (const unsigned char*)&sighash, 32, 0,
-                    condBinary.data(), condBinary.size(), eval, (void*)this, true);
+    out = VerifyCryptoConditionSignatures(cond, sighash, condBinary, ffillBin) &&
+          cc_verifyEval(cond, eval, (void*)this);
 
     //fprintf(stderr,"out.%d from cc_verify\n",(int32_t)out);
     cc_free(cond);
@@ -1792,6 +1792,15 @@ int TransactionSignatureChecker::CheckEvalCondition(const CC *cond, int filfille
     return true;
 }
 
+bool TransactionSignatureChecker::VerifyCryptoConditionSignatures(
+    const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBinary, const std::vector<unsigned char>& ffillBin) const
+{
+    VerifyEval noEval = [] (CC *cond, void *checker, int fulfilled) {
+        return 1;
+    };
+    return cc_verify(cond, sighash.begin(), 32, 0, condBinary.data(), condBinary.size(), noEval, nullptr, true);
+}
+
 
 bool TransactionSignatureChecker::CheckLockTime(const CScriptNum& nLockTime) const
 {
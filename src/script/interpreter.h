@@ -98,6 +98,7 @@ struct PrecomputedTransactionData
 {
     uint256 hashPrevouts, hashSequence, hashOutputs, hashJoinSplits, hashShieldedSpends, hashShieldedOutputs;
 
+    PrecomputedTransactionData() {}
     PrecomputedTransactionData(const CTransaction& tx);
 };
 
@@ -193,6 +194,10 @@ public:
         const CScript& scriptCode,
         uint32_t consensusBranchId) const;
     virtual int CheckEvalCondition(const CC *cond, int fulfilled) const;
+
+    // checks the condition binary and signatures of a fulfilled condition, but not its eval callbacks, which depend on
+    // chain state and must be run by the caller on every check
+    virtual bool VerifyCryptoConditionSignatures(const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBinary, const std::vector<unsigned char>& ffillBin) const;
 };
 
 class MutableTransactionSignatureChecker : public TransactionSignatureChecker
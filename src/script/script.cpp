@@ -1902,25 +1902,26 @@ bool operator<(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
         return false;
     }
 
-    bool isaltb = false;
-    std::set<uint160> checked;
-
     // ensure that we are smaller than all those present in b
+    auto ait = a.valueMap.begin();
     for (auto &oneVal : b.valueMap)
     {
-        checked.insert(oneVal.first);
+        while (ait != a.valueMap.end() && ait->first < oneVal.first)
+        {
+            ait++;
+        }
         if (oneVal.second)
         {
-            auto it = a.valueMap.find(oneVal.first);
+            bool inA = ait != a.valueMap.end() && ait->first == oneVal.first;
 
             // negative is less than not present, which is equivalent to 0
-            if ((it == a.valueMap.end() && oneVal.second > 0) || (it != a.valueMap.end() && it->second < oneVal.second))
+            if ((!inA && oneVal.second > 0) || (inA && ait->second < oneVal.second))
             {
-                isaltb = true;
+                return true;
             }
         }
     }
-    return isaltb;
+    return false;
 }
 
 bool LegacyLT(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
@@ -1928,44 +1929,25 @@ bool LegacyLT(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
     // to be less than means, in this order:
     // 1. To have fewer non-zero currencies.
     // 2. If not fewer currencies, all present currencies must be less in a than b
-    if (!a.valueMap.size() && !b.valueMap.size())
+    if (!(a < b))
     {
         return false;
     }
 
-    bool isaltb = false;
-    std::set<uint160> checked;
-
-    // ensure that we are smaller than all those present in b
-    for (auto &oneVal : b.valueMap)
-    {
-        checked.insert(oneVal.first);
-        if (oneVal.second)
-        {
-            auto it = a.valueMap.find(oneVal.first);
-
-            // negative is less than not present, which is equivalent to 0
-            if ((it == a.valueMap.end() && oneVal.second > 0) || (it != a.valueMap.end() && it->second < oneVal.second))
-            {
-                isaltb = true;
-            }
-        }
-    }
-
     // ensure that for all the currencies we have, b does not have less or equal
+    auto bit = b.valueMap.begin();
     for (auto &oneVal : a.valueMap)
     {
-        if (!checked.count(oneVal.first) && oneVal.second)
+        while (bit != b.valueMap.end() && bit->first < oneVal.first)
         {
-            auto it = b.valueMap.find(oneVal.first);
-
-            if ((it == b.valueMap.end() && oneVal.second > 0) || (it != b.valueMap.end() && it->second < oneVal.second))
-            {
-                isaltb = false;
-            }
+            bit++;
+        }
+        if (oneVal.second > 0 && (bit == b.valueMap.end() || !(bit->first == oneVal.first)))
+        {
+            return false;
         }
     }
-    return isaltb;
+    return true;
 }
 
 bool operator>(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
@@ -1973,25 +1955,31 @@ bool operator>(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
     return b < a;
 }
 
-bool operator==(const CCurrencyValueMap& _a, const CCurrencyValueMap& _b)
+bool operator==(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
 {
-    CCurrencyValueMap a = _a.CanonicalMap(), b = _b.CanonicalMap();
-    if (a.valueMap.size() != b.valueMap.size())
+    // equal if the same currencies have the same non-zero values
+    auto ait = a.valueMap.begin(), bit = b.valueMap.begin();
+    while (true)
     {
-        return false;
-    }
-
-    bool isaeqb = true;
-    for (auto &oneVal : a.valueMap)
-    {
-        auto it = b.valueMap.find(oneVal.first);
-        if (it == b.valueMap.end() || it->second != oneVal.second)
+        while (ait != a.valueMap.end() && !ait->second)
         {
-            isaeqb = false;
-            break;
+            ait++;
+        }
+        while (bit != b.valueMap.end() && !bit->second)
+        {
+            bit++;
         }
+        if (ait == a.valueMap.end() || bit == b.valueMap.end())
+        {
+            return ait == a.valueMap.end() && bit == b.valueMap.end();
+        }
+        if (!(ait->first == bit->first) || ait->second != bit->second)
+        {
+            return false;
+        }
+        ait++;
+        bit++;
     }
-    return isaeqb;
 }
 
 bool operator!=(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
@@ -2012,33 +2000,46 @@ bool operator<=(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
     bool isalteb = false;
 
     // ensure that we are smaller than all those present in b
+    auto ait = a.valueMap.begin();
     for (auto &oneVal : b.valueMap)
     {
+        while (ait != a.valueMap.end() && ait->first < oneVal.first)
+        {
+            ait++;
+        }
         if (oneVal.second)
         {
-            auto it = a.valueMap.find(oneVal.first);
-
-            if ((it == a.valueMap.end() && oneVal.second >= 0) || (it != a.valueMap.end() && it->second <= oneVal.second))
+            bool inA = ait != a.valueMap.end() && ait->first == oneVal.first;
+            if ((!inA && oneVal.second >= 0) || (inA && ait->second <= oneVal.second))
             {
                 isalteb = true;
+                break;
             }
         }
     }
+    if (!isalteb)
+    {
+        return false;
+    }
 
     // ensure that for all the currencies we have, b has equal or more
+    auto bit = b.valueMap.begin();
     for (auto &oneVal : a.valueMap)
     {
+        while (bit != b.valueMap.end() && bit->first < oneVal.first)
+        {
+            bit++;
+        }
         if (oneVal.second)
         {
-            auto it = b.valueMap.find(oneVal.first);
-
-            if ((it == b.valueMap.end() && oneVal.second > 0) || (it != b.valueMap.end() && it->second < oneVal.second))
+            bool inB = bit != b.valueMap.end() && bit->first == oneVal.first;
+            if ((!inB && oneVal.second > 0) || (inB && bit->second < oneVal.second))
             {
-                isalteb = false;
+                return false;
             }
         }
     }
-    return isalteb;
+    return true;
 }
 
 bool operator>=(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
@@ -2046,46 +2047,50 @@ bool operator>=(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
     return b <= a;
 }
 
-CCurrencyValueMap operator+(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
+// merges a and b in currency order, with values present in only one of them combined with 0
+template <typename Combine>
+static CCurrencyValueMap MergeValueMaps(const CCurrencyValueMap& a, const CCurrencyValueMap& b, Combine combine)
 {
-    CCurrencyValueMap retVal = a;
-    if (a.valueMap.size() || b.valueMap.size())
+    CCurrencyValueMap retVal;
+    retVal.valueMap.reserve(a.valueMap.size() + b.valueMap.size());
+    auto ait = a.valueMap.begin(), bit = b.valueMap.begin();
+    while (ait != a.valueMap.end() || bit != b.valueMap.end())
     {
-        for (auto &oneVal : b.valueMap)
+        if (bit == b.valueMap.end() || (ait != a.valueMap.end() && ait->first < bit->first))
         {
-            auto it = retVal.valueMap.find(oneVal.first);
-            if (it == retVal.valueMap.end())
-            {
-                retVal.valueMap[oneVal.first] = oneVal.second;
-            }
-            else
-            {
-                it->second += oneVal.second;
-            }
+            retVal.valueMap.push_back(*ait++);
+        }
+        else if (ait == a.valueMap.end() || bit->first < ait->first)
+        {
+            retVal.valueMap.push_back(std::make_pair(bit->first, combine(0, bit->second)));
+            bit++;
+        }
+        else
+        {
+            retVal.valueMap.push_back(std::make_pair(ait->first, combine(ait->second, bit->second)));
+            ait++;
+            bit++;
         }
     }
     return retVal;
 }
 
+CCurrencyValueMap operator+(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
+{
+    if (!b.valueMap.size())
+    {
+        return a;
+    }
+    return MergeValueMaps(a, b, [](int64_t x, int64_t y) { return x + y; });
+}
+
 CCurrencyValueMap operator-(const CCurrencyValueMap& a, const CCurrencyValueMap& b)
 {
-    CCurrencyValueMap retVal = a;
-    if (a.valueMap.size() || b.valueMap.size())
+    if (!b.valueMap.size())
     {
-        for (auto &oneVal : b.valueMap)
-        {
-            auto it = retVal.valueMap.find(oneVal.first);
-            if (it == retVal.valueMap.end())
-            {
-                retVal.valueMap[oneVal.first] = -oneVal.second;
-            }
-            else
-            {
-                it->second -= oneVal.second;
-            }
-        }
+        return a;
     }
-    return retVal;
+    return MergeValueMaps(a, b, [](int64_t x, int64_t y) { return x - y; });
 }
 
 CCurrencyValueMap operator+(const CCurrencyValueMap& a, int b)
@@ -2130,52 +2135,87 @@ CCurrencyValueMap operator/(const CCurrencyValueMap& a, int b)
 
 const CCurrencyValueMap &CCurrencyValueMap::operator-=(const CCurrencyValueMap& operand)
 {
-    return *this = *this - operand;
+    // currencies already present are updated in place, which avoids building a new map
+    for (auto &oneVal : operand.valueMap)
+    {
+        if (!valueMap.count(oneVal.first))
+        {
+            return *this = *this - operand;
+        }
+    }
+    auto it = valueMap.begin();
+    for (auto &oneVal : operand.valueMap)
+    {
+        while (!(it->first == oneVal.first))
+        {
+            it++;
+        }
+        it->second -= oneVal.second;
+    }
+    return *this;
 }
 
 const CCurrencyValueMap &CCurrencyValueMap::operator+=(const CCurrencyValueMap& operand)
 {
-    return *this = *this + operand;
+    // currencies already present are updated in place, which avoids building a new map
+    for (auto &oneVal : operand.valueMap)
+    {
+        if (!valueMap.count(oneVal.first))
+        {
+            return *this = *this + operand;
+        }
+    }
+    auto it = valueMap.begin();
+    for (auto &oneVal : operand.valueMap)
+    {
+        while (!(it->first == oneVal.first))
+        {
+            it++;
+        }
+        it->second += oneVal.second;
+    }
+    return *this;
 }
 
 // determine if the operand intersects this map
 bool CCurrencyValueMap::Intersects(const CCurrencyValueMap& operand) const
 {
-    bool retVal = false;
-
-    if (valueMap.size() && operand.valueMap.size())
+    auto it = operand.valueMap.begin();
+    for (auto &oneVal : valueMap)
     {
-        for (auto &oneVal : valueMap)
+        while (it != operand.valueMap.end() && it->first < oneVal.first)
         {
-            auto it = operand.valueMap.find(oneVal.first);
-            if (it != operand.valueMap.end())
-            {
-                if (it->second != 0 && oneVal.second != 0)
-                {
-                    retVal = true;
-                    break;
-                }
-            }
+            it++;
+        }
+        if (it == operand.valueMap.end())
+        {
+            break;
+        }
+        if (it->first == oneVal.first && it->second != 0 && oneVal.second != 0)
+        {
+            return true;
         }
     }
-    return retVal;
+    return false;
 }
 
 CCurrencyValueMap CCurrencyValueMap::IntersectingValues(const CCurrencyValueMap& operand) const
 {
     CCurrencyValueMap retVal;
-
-    if (valueMap.size() && operand.valueMap.size())
+    auto it = operand.valueMap.begin();
+    for (auto &oneVal : valueMap)
     {
-        for (auto &oneVal : valueMap)
+        while (it != operand.valueMap.end() && it->first < oneVal.first)
         {
-            auto it = operand.valueMap.find(oneVal.first);
-            if (it != operand.valueMap.end() &&
-                it->second != 0 &&
-                oneVal.second != 0)
-            {
-                retVal.valueMap[oneVal.first] = oneVal.second;
-            }
+            it++;
+        }
+        if (it == operand.valueMap.end())
+        {
+            break;
+        }
+        if (it->first == oneVal.first && it->second != 0 && oneVal.second != 0)
+        {
+            retVal.valueMap.push_back(oneVal);
         }
     }
     return retVal;
@@ -2184,11 +2224,11 @@ CCurrencyValueMap CCurrencyValueMap::IntersectingValues(const CCurrencyValueMap&
 CCurrencyValueMap CCurrencyValueMap::CanonicalMap() const
 {
     CCurrencyValueMap retVal;
-    for (auto valPair : valueMap)
+    for (auto &valPair : valueMap)
     {
         if (valPair.second != 0)
         {
-            retVal.valueMap.insert(valPair);
+            retVal.valueMap.push_back(valPair);
         }
     }
     return retVal;
@@ -2196,24 +2236,24 @@ CCurrencyValueMap CCurrencyValueMap::CanonicalMap() const
 
 CCurrencyValueMap CCurrencyValueMap::NonIntersectingValues(const CCurrencyValueMap& operand) const
 {
-    CCurrencyValueMap retVal = *this;
+    if (!valueMap.size() || !operand.valueMap.size())
+    {
+        return *this;
+    }
 
-    if (valueMap.size() && operand.valueMap.size())
+    // non-zero values of currencies that are not non-zero in the operand
+    CCurrencyValueMap retVal;
+    auto it = operand.valueMap.begin();
+    for (auto &oneVal : valueMap)
     {
-        for (auto &oneVal : valueMap)
+        while (it != operand.valueMap.end() && it->first < oneVal.first)
         {
-            if (oneVal.second)
-            {
-                auto it = operand.valueMap.find(oneVal.first);
-                if (it != operand.valueMap.end() && it->second != 0)
-                {
-                    retVal.valueMap.erase(it->first);
-                }
-            }
-            else
-            {
-                retVal.valueMap.erase(oneVal.first);
-            }
+            it++;
+        }
+        if (oneVal.second &&
+            (it == operand.valueMap.end() || !(it->first == oneVal.first) || it->second == 0))
+        {
+            retVal.valueMap.push_back(oneVal);
         }
     }
     return retVal;
@@ -8,6 +8,8 @@
 #include "script/cc.h"
 #include "cc/eval.h"
 
+#include "crypto/sha256.h"
+#include "memusage.h"
 #include "pubkey.h"
 #include "random.h"
 #include "uint256.h"
@@ -19,6 +21,7 @@
 #undef __cpuid
 #include <boost/thread.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
+#include <boost/unordered_set.hpp>
 
 extern uint32_t KOMODO_STOPAT;
 extern int32_t VERUS_MIN_STAKEAGE;
@@ -105,6 +108,74 @@ public:
     }
 };
 
+class CCryptoConditionCacheHasher
+{
+public:
+    size_t operator()(const uint256& key) const {
+        return key.GetCheapHash();
+    }
+};
+
+/**
+ * Crypto-conditions whose condition binary and signatures have been verified for a signature hash, so that inputs
+ * checked on entry to the memory pool do not have their signatures verified again when the block is connected.
+ * Eval callbacks depend on the chain state when they are run, so their results are never cached.
+ */
+class CCryptoConditionCache
+{
+private:
+    //! Entries are SHA256(nonce || signature hash || condition binary || fulfillment)
+    uint256 nonce;
+    typedef boost::unordered_set<uint256, CCryptoConditionCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_cccache;
+
+public:
+    CCryptoConditionCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& condBinary, const std::vector<unsigned char>& ffillBin)
+    {
+        CSHA256().Write(nonce.begin(), 32)
+                 .Write(hash.begin(), 32)
+                 .Write(condBinary.data(), condBinary.size())
+                 .Write(ffillBin.data(), ffillBin.size())
+                 .Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_cccache);
+        return setValid.count(entry);
+    }
+
+    void Erase(const uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_cccache);
+        setValid.erase(entry);
+    }
+
+    void Set(const uint256& entry)
+    {
+        size_t nMaxCacheSize = GetArg("-maxcccachesize", DEFAULT_MAX_CC_CACHE_SIZE) * ((size_t) 1 << 20);
+        if (nMaxCacheSize <= 0) return;
+
+        boost::unique_lock<boost::shared_mutex> lock(cs_cccache);
+        while (memusage::DynamicUsage(setValid) > nMaxCacheSize)
+        {
+            map_type::size_type s = GetRand(setValid.bucket_count());
+            map_type::local_iterator it = setValid.begin(s);
+            if (it != setValid.end(s)) {
+                setValid.erase(*it);
+            }
+        }
+
+        setValid.insert(entry);
+    }
+};
+
 }
 
 // uses blockchain lookup
@@ -233,6 +304,30 @@ bool ServerTransactionSignatureChecker::VerifySignature(const std::vector<unsign
  * code without pulling the whole bitcoin server code into bitcoin common was
  * using this class. Thus it has been renamed to ServerTransactionSignatureChecker.
  */
+bool ServerTransactionSignatureChecker::VerifyCryptoConditionSignatures(
+    const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBinary, const std::vector<unsigned char>& ffillBin) const
+{
+    static CCryptoConditionCache ccCache;
+
+    uint256 entry;
+    ccCache.ComputeEntry(entry, sighash, condBinary, ffillBin);
+
+    if (ccCache.Get(entry)) {
+        if (!store) {
+            ccCache.Erase(entry);
+        }
+        return true;
+    }
+
+    if (!TransactionSignatureChecker::VerifyCryptoConditionSignatures(cond, sighash, condBinary, ffillBin))
+        return false;
+
+    if (store) {
+        ccCache.Set(entry);
+    }
+    return true;
+}
+
 int ServerTransactionSignatureChecker::CheckEvalCondition(const CC *cond, int fulfilled) const
 {
     //fprintf(stderr,"call RunCCeval from ServerTransactionSignatureChecker::CheckEvalCondition\n");
@@ -10,6 +10,9 @@
 
 #include <vector>
 
+// limit the cache of verified crypto-condition signatures to less than 10MB
+static const unsigned int DEFAULT_MAX_CC_CACHE_SIZE = 10;
+
 class CPubKey;
 
 class ServerTransactionSignatureChecker : public TransactionSignatureChecker
@@ -26,6 +29,7 @@ public:
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
     int CheckEvalCondition(const CC *cond, int fulfilled) const;
+    bool VerifyCryptoConditionSignatures(const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBinary, const std::vector<unsigned char>& ffillBin) const;
 };
 
 #endif // BITCOIN_SCRIPT_SERVERCHECKER_H
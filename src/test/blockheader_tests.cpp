@@ -0,0 +1,58 @@
+// Copyright (c) 2022 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "hash.h"
+#include "primitives/block.h"
+#include "random.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockheader_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(cached_hash_follows_changes)
+{
+    CBlockHeader header;
+    header.hashPrevBlock = GetRandHash();
+    header.hashMerkleRoot = GetRandHash();
+    header.nTime = 1600000000;
+    header.nBits = 0x1d00ffff;
+    header.nSolution = std::vector<unsigned char>(1344, 1);
+
+    uint256 hash = header.GetHash();
+    uint64_t nComputed = CBlockHeader::nHashesComputed.load();
+    BOOST_CHECK(header.GetHash() == hash);
+    BOOST_CHECK_EQUAL(CBlockHeader::nHashesComputed.load(), nComputed);
+
+    // copies share the cached hash until either one changes
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == hash);
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == hash);
+    BOOST_CHECK_EQUAL(CBlockHeader::nHashesComputed.load(), nComputed);
+
+    header.nNonce = GetRandHash();
+    BOOST_CHECK(header.GetHash() != hash);
+    BOOST_CHECK(header.GetHash() == SerializeHash(header));
+    BOOST_CHECK(block.GetHash() == hash);
+
+    block.nSolution[100] = 2;
+    BOOST_CHECK(block.GetHash() != hash);
+    BOOST_CHECK(block.GetHash() == SerializeHash(block.GetBlockHeader()));
+
+    // a deserialized header never keeps the hash of what it held before
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << header;
+    CBlockHeader readHeader(block);
+    ss >> readHeader;
+    BOOST_CHECK(readHeader.GetHash() == header.GetHash());
+
+    // a hash cached by the caller is returned until the header changes
+    readHeader.CacheHash(hash);
+    BOOST_CHECK(readHeader.GetHash() == hash);
+    readHeader.nTime++;
+    BOOST_CHECK(readHeader.GetHash() == SerializeHash(readHeader));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,6 +13,7 @@
 #include "undo.h"
 #include "primitives/transaction.h"
 #include "pubkey.h"
+#include "txdb.h"
 
 #include <vector>
 #include <map>
@@ -1091,4 +1092,60 @@ BOOST_AUTO_TEST_CASE(ccoins_serialization)
     }
 }
 
+// the running statistics of the coin database must match a scan of it after outputs are created, spent one at a time,
+// restored as when a block is disconnected, and erased
+BOOST_AUTO_TEST_CASE(coins_db_running_stats)
+{
+    CCoinsViewDB db(1 << 20, true);
+    BOOST_CHECK(db.InitStats());
+
+    std::vector<uint256> txids;
+    for (unsigned int i = 0; i < 50; i++) {
+        txids.push_back(GetRandHash());
+    }
+    std::map<uint256, CCoins> createdCoins;
+
+    for (unsigned int block = 0; block < 40; block++) {
+        CCoinsViewCache cache(&db);
+        for (unsigned int i = 0; i < 20; i++) {
+            const uint256 &txid = txids[insecure_rand() % txids.size()];
+            CCoinsModifier coins = cache.ModifyCoins(txid);
+            if (coins->IsPruned()) {
+                coins->nVersion = 1;
+                coins->nHeight = block;
+                coins->fCoinBase = insecure_rand() % 2;
+                coins->vout.resize(1 + insecure_rand() % 5);
+                for (uint32_t n = 0; n < coins->vout.size(); n++) {
+                    coins->vout[n].nValue = 1 + insecure_rand() % 1000;
+                    coins->vout[n].scriptPubKey = CScript() << OP_1 << (int64_t)n;
+                }
+                createdCoins[txid] = *coins;
+            } else if (insecure_rand() % 4 == 0) {
+                coins->Clear();
+            } else {
+                uint32_t n = insecure_rand() % coins->vout.size();
+                if (coins->IsAvailable(n)) {
+                    coins->Spend(n);
+                } else if (n < createdCoins[txid].vout.size()) {
+                    coins->vout[n] = createdCoins[txid].vout[n];
+                }
+            }
+        }
+        cache.SetBestBlock(GetRandHash());
+        BOOST_CHECK(cache.Flush());
+
+        CCoinsStats running, scanned;
+        BOOST_CHECK(db.GetStats(running));
+        BOOST_CHECK(db.ScanStats(scanned));
+        BOOST_CHECK(running.hashBlock == scanned.hashBlock);
+        BOOST_CHECK_EQUAL(running.nTransactions, scanned.nTransactions);
+        BOOST_CHECK_EQUAL(running.nTransactionOutputs, scanned.nTransactionOutputs);
+        BOOST_CHECK_EQUAL(running.nSerializedSize, scanned.nSerializedSize);
+        BOOST_CHECK_EQUAL(running.nTotalAmount, scanned.nTotalAmount);
+        BOOST_CHECK(running.hashMuHash == scanned.hashMuHash);
+        BOOST_CHECK(running.hashSerialized.IsNull());
+        BOOST_CHECK(!scanned.hashSerialized.IsNull());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+// Copyright (c) 2021 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "pbaas/reserves.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <random>
+
+BOOST_FIXTURE_TEST_SUITE(conversion_tests, BasicTestingSetup)
+
+// supplies and reserves well beyond any real currency, and close to the limits of CAmount
+static const CAmount MAX_TEST_AMOUNT = 1000000000000000000LL;
+
+// log uniformly distributed amount in [1, max]
+static CAmount RandomAmount(std::mt19937_64 &rng, CAmount max)
+{
+    std::uniform_real_distribution<double> distribution(0, std::log((double)max));
+    return std::max((CAmount)1, std::min(max, (CAmount)std::exp(distribution(rng))));
+}
+
+static int32_t RandomRatio(std::mt19937_64 &rng)
+{
+    switch (rng() % 4)
+    {
+        case 0:
+            return CCurrencyState::MAX_RESERVE_RATIO;
+        case 1:
+            return (rng() % 10 + 1) * 10000000;
+        default:
+            return CCurrencyState::SHUTDOWN_RESERVE_RATIO + rng() % (CCurrencyState::MAX_RESERVE_RATIO - CCurrencyState::SHUTDOWN_RESERVE_RATIO + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fixed_point_edge_cases)
+{
+    CAmount out;
+
+    // nothing in, nothing out, and inputs the kernel does not handle are left to the reference
+    BOOST_CHECK(!FixedPointFractionalOut(0, 100 * COIN, 100 * COIN, 50000000, out));
+    BOOST_CHECK(!FixedPointReserveOut(0, 100 * COIN, 100 * COIN, 50000000, out));
+    BOOST_CHECK(!FixedPointFractionalOut(COIN, 100 * COIN, 100 * COIN, CCurrencyState::MIN_RESERVE_RATIO - 1, out));
+    BOOST_CHECK(!FixedPointReserveOut(100 * COIN, 100 * COIN, 100 * COIN, 50000000, out));
+    BOOST_CHECK_EQUAL(CalculateFractionalOut(0, 100 * COIN, 100 * COIN, 50000000), 0);
+    BOOST_CHECK_EQUAL(CalculateReserveOut(0, 100 * COIN, 100 * COIN, 50000000), 0);
+
+    // results that are exactly whole satoshis depend on the reference's rounding, so they are never decided by the kernel
+    BOOST_CHECK(!FixedPointFractionalOut(COIN, 100 * COIN, 100 * COIN, CCurrencyState::MAX_RESERVE_RATIO, out));
+    BOOST_CHECK_EQUAL(CalculateFractionalOut(COIN, 100 * COIN, 100 * COIN, CCurrencyState::MAX_RESERVE_RATIO),
+                      CalculateFractionalOutReference(COIN, 100 * COIN, 100 * COIN, CCurrencyState::MAX_RESERVE_RATIO));
+
+    BOOST_CHECK(FixedPointFractionalOut(COIN, 100 * COIN, 100 * COIN, 50000000, out));
+    BOOST_CHECK_EQUAL(out, CalculateFractionalOutReference(COIN, 100 * COIN, 100 * COIN, 50000000));
+    BOOST_CHECK(FixedPointReserveOut(COIN, 100 * COIN, 100 * COIN, 40000000, out));
+    BOOST_CHECK_EQUAL(out, CalculateReserveOutReference(COIN, 100 * COIN, 100 * COIN, 40000000));
+}
+
+// differential test of the fixed point kernel against the cpp_dec_float_50 reference. any decided result that differs
+// from the reference by even a satoshi would be a consensus failure.
+BOOST_AUTO_TEST_CASE(fixed_point_matches_reference)
+{
+    const int nIterations = 100000;
+    std::mt19937_64 rng(1);
+    int nDecided = 0;
+
+    for (int i = 0; i < nIterations; i++)
+    {
+        CAmount supply = (rng() % 16) ? RandomAmount(rng, MAX_TEST_AMOUNT) : 0;
+        CAmount reserve = (rng() % 16) ? RandomAmount(rng, MAX_TEST_AMOUNT) : 0;
+        int32_t ratio = RandomRatio(rng);
+        CAmount out;
+
+        CAmount reserveIn = RandomAmount(rng, MAX_TEST_AMOUNT);
+        if (FixedPointFractionalOut(reserveIn, supply, reserve, ratio, out))
+        {
+            nDecided++;
+            BOOST_CHECK_MESSAGE(out == CalculateFractionalOutReference(reserveIn, supply, reserve, ratio),
+                                strprintf("CalculateFractionalOut(%d, %d, %d, %d) = %d", reserveIn, supply, reserve, ratio, out));
+        }
+
+        CAmount fractionalIn = RandomAmount(rng, std::max(supply, (CAmount)2) - 1);
+        if (FixedPointReserveOut(fractionalIn, supply, reserve, ratio, out))
+        {
+            nDecided++;
+            BOOST_CHECK_MESSAGE(out == CalculateReserveOutReference(fractionalIn, supply, reserve, ratio),
+                                strprintf("CalculateReserveOut(%d, %d, %d, %d) = %d", fractionalIn, supply, reserve, ratio, out));
+        }
+    }
+
+    // the reference should only be needed close to whole satoshis, outside the kernel's ratio range and on overflow
+    BOOST_CHECK(nDecided > nIterations);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -118,6 +118,45 @@ BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_iterator_seek_before)
+{
+    path ph = temp_directory_path() / unique_path();
+    CDBWrapper dbw(ph, (1 << 20), true, false);
+
+    BOOST_CHECK(dbw.Write('b', (uint32_t)1));
+    BOOST_CHECK(dbw.Write('d', (uint32_t)2));
+    BOOST_CHECK(dbw.Write('f', (uint32_t)3));
+
+    boost::scoped_ptr<CDBIterator> it(const_cast<CDBWrapper*>(&dbw)->NewIterator());
+    char key_res;
+    uint32_t val_res;
+
+    // the last entry before a key that is not present
+    it->SeekBefore('e');
+    BOOST_CHECK(it->Valid() && it->GetKey(key_res) && it->GetValue(val_res));
+    BOOST_CHECK_EQUAL(key_res, 'd');
+    BOOST_CHECK_EQUAL(val_res, 2);
+
+    // an entry at the key itself is excluded, and the walk continues backwards
+    it->SeekBefore('f');
+    BOOST_CHECK(it->Valid() && it->GetKey(key_res));
+    BOOST_CHECK_EQUAL(key_res, 'd');
+    it->Prev();
+    BOOST_CHECK(it->Valid() && it->GetKey(key_res));
+    BOOST_CHECK_EQUAL(key_res, 'b');
+    it->Prev();
+    BOOST_CHECK(!it->Valid());
+
+    // past the last key
+    it->SeekBefore('z');
+    BOOST_CHECK(it->Valid() && it->GetKey(key_res));
+    BOOST_CHECK_EQUAL(key_res, 'f');
+
+    // before the first key
+    it->SeekBefore('a');
+    BOOST_CHECK(!it->Valid());
+}
+
 BOOST_AUTO_TEST_CASE(iterator_ordering)
 {
     path ph = temp_directory_path() / unique_path();
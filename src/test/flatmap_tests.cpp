@@ -0,0 +1,56 @@
+// Copyright (c) 2021 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "flatmap.h"
+#include "random.h"
+#include "streams.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flatmap_tests, BasicTestingSetup)
+
+// random inserts, erases and lookups must leave a flatmap identical to a std::map, including its serialization
+BOOST_AUTO_TEST_CASE(flatmap_matches_map)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        std::map<int, int64_t> real;
+        flatmap<2, int, int64_t> flat;
+        for (int j = 0; j < 50; j++)
+        {
+            int key = insecure_rand() % 16;
+            switch (insecure_rand() % 4)
+            {
+                case 0:
+                    real[key] += j;
+                    flat[key] += j;
+                    break;
+                case 1:
+                    BOOST_CHECK_EQUAL(real.erase(key), flat.erase(key));
+                    break;
+                case 2:
+                    BOOST_CHECK_EQUAL(real.insert(std::make_pair(key, j)).second, flat.insert(std::make_pair(key, j)).second);
+                    break;
+                default:
+                    BOOST_CHECK_EQUAL(real.count(key), flat.count(key));
+                    BOOST_CHECK((real.find(key) == real.end()) == (flat.find(key) == flat.end()));
+                    break;
+            }
+            BOOST_CHECK(real == (std::map<int, int64_t>)flat);
+        }
+
+        CDataStream realStream(SER_DISK, 0), flatStream(SER_DISK, 0);
+        realStream << real;
+        flatStream << flat;
+        BOOST_CHECK(realStream.str() == flatStream.str());
+
+        flatmap<2, int, int64_t> flat2;
+        realStream >> flat2;
+        BOOST_CHECK(flat2 == flat);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
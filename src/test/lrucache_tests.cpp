@@ -0,0 +1,101 @@
+// Copyright (c) 2022 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "lrucache.h"
+#include "random.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+
+BOOST_FIXTURE_TEST_SUITE(lrucache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sharded_lru_evicts_least_recent)
+{
+    // one shard, so eviction order is exactly least recently used first
+    size_t entrySize = LRUCacheObjectSize(uint256()) + LRUCacheObjectSize(int64_t()) + 96;
+    CShardedLRUCache<uint256, int64_t> cache(entrySize * 3, 1);
+
+    std::vector<uint256> keys;
+    for (int i = 0; i < 4; i++)
+    {
+        keys.push_back(GetRandHash());
+    }
+    cache.Put(keys[0], 0);
+    cache.Put(keys[1], 1);
+    cache.Put(keys[2], 2);
+    BOOST_CHECK_EQUAL(cache.Get(keys[0]), 0);
+
+    // keys[1] is now the least recently used
+    cache.Put(keys[3], 3);
+    BOOST_CHECK(!cache.count(keys[1]));
+    BOOST_CHECK(cache.count(keys[0]) && cache.count(keys[2]) && cache.count(keys[3]));
+
+    int64_t value;
+    BOOST_CHECK(!cache.Get(keys[1], value));
+    BOOST_CHECK(cache.Get(keys[3], value) && value == 3);
+
+    auto stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 3);
+    BOOST_CHECK_EQUAL(stats.usedBytes, entrySize * 3);
+    BOOST_CHECK_EQUAL(stats.hits, 2);
+    BOOST_CHECK_EQUAL(stats.misses, 1);
+    BOOST_CHECK_EQUAL(stats.evictions, 1);
+
+    BOOST_CHECK(cache.Erase(keys[2]));
+    BOOST_CHECK(!cache.Erase(keys[2]));
+    BOOST_CHECK(!cache.count(keys[2]));
+    BOOST_CHECK_EQUAL(cache.GetStats().usedBytes, entrySize * 2);
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(sharded_lru_concurrent_access)
+{
+    CShardedLRUCache<std::tuple<uint160, uint256, bool>, int> cache(1 << 20);
+    std::vector<std::tuple<uint160, uint256, bool>> keys;
+    for (int i = 0; i < 256; i++)
+    {
+        uint256 hash = GetRandHash();
+        keys.push_back({uint160(std::vector<unsigned char>(hash.begin(), hash.begin() + 20)), hash, i & 1});
+    }
+
+    // Boost.Test checks are not thread safe, so threads only count mismatches
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, &keys, &mismatches]() {
+            for (int round = 0; round < 100; round++)
+            {
+                for (int i = 0; i < (int)keys.size(); i++)
+                {
+                    int value;
+                    if (!cache.Get(keys[i], value))
+                    {
+                        cache.Put(keys[i], i);
+                    }
+                    else if (value != i)
+                    {
+                        mismatches++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &oneThread : threads)
+    {
+        oneThread.join();
+    }
+
+    BOOST_CHECK_EQUAL(mismatches, 0);
+    auto stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, keys.size());
+    BOOST_CHECK_EQUAL(stats.evictions, 0);
+    BOOST_CHECK_EQUAL(stats.hits + stats.misses, 4 * 100 * keys.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -222,4 +222,132 @@ BOOST_AUTO_TEST_CASE(SetSanityCheck) {
     BOOST_CHECK_EQUAL(pool.GetCheckFrequency(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
+{
+    CTxMemPool pool(CFeeRate(1000));
+    TestMemPoolEntryHelper entry;
+    entry.dPriority = 10.0;
+    CCurrencyState noConversion;
+
+    CMutableTransaction tx1 = CMutableTransaction();
+    tx1.vin.resize(1);
+    tx1.vin[0].prevout.n = 1;
+    tx1.vin[0].scriptSig = CScript() << OP_1;
+    tx1.vout.resize(1);
+    tx1.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx1.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx1.GetHash(), entry.Fee(40000LL).FromTx(tx1, &pool));
+
+    CMutableTransaction tx2 = CMutableTransaction();
+    tx2.vin.resize(1);
+    tx2.vin[0].prevout.n = 2;
+    tx2.vin[0].scriptSig = CScript() << OP_2;
+    tx2.vout.resize(1);
+    tx2.vout[0].scriptPubKey = CScript() << OP_2 << OP_EQUAL;
+    tx2.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(5000LL).FromTx(tx2, &pool));
+
+    // nothing is evicted while the pool fits
+    pool.TrimToSize(pool.DynamicMemoryUsage(), noConversion);
+    BOOST_CHECK(pool.exists(tx1.GetHash()));
+    BOOST_CHECK(pool.exists(tx2.GetHash()));
+
+    // the lower fee rate transaction goes first
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1, noConversion);
+    BOOST_CHECK(pool.exists(tx1.GetHash()));
+    BOOST_CHECK(!pool.exists(tx2.GetHash()));
+
+    // the rolling minimum is raised above the evicted rate
+    CFeeRate tx2Rate(5000LL, ::GetSerializeSize(tx2, SER_NETWORK, PROTOCOL_VERSION));
+    BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), tx2Rate.GetFeePerK() + 1000);
+
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(5000LL).FromTx(tx2, &pool));
+
+    // a zero fee parent with a high fee child is worth its package rate, so it outlives tx2
+    CMutableTransaction tx3 = CMutableTransaction();
+    tx3.vin.resize(1);
+    tx3.vin[0].prevout.n = 3;
+    tx3.vin[0].scriptSig = CScript() << OP_3;
+    tx3.vout.resize(1);
+    tx3.vout[0].scriptPubKey = CScript() << OP_3 << OP_EQUAL;
+    tx3.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx3.GetHash(), entry.Fee(0LL).FromTx(tx3, &pool));
+
+    CMutableTransaction tx4 = CMutableTransaction();
+    tx4.vin.resize(1);
+    tx4.vin[0].prevout = COutPoint(tx3.GetHash(), 0);
+    tx4.vin[0].scriptSig = CScript() << OP_4;
+    tx4.vout.resize(1);
+    tx4.vout[0].scriptPubKey = CScript() << OP_4 << OP_EQUAL;
+    tx4.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx4.GetHash(), entry.Fee(30000LL).FromTx(tx4, &pool));
+
+    std::set<uint256> setDescendants;
+    pool.CalculateDescendants(tx3.GetHash(), setDescendants);
+    BOOST_CHECK_EQUAL(setDescendants.size(), 2);
+
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1, noConversion);
+    BOOST_CHECK(!pool.exists(tx2.GetHash()));
+    BOOST_CHECK(pool.exists(tx3.GetHash()));
+    BOOST_CHECK(pool.exists(tx4.GetHash()));
+
+    // evicting the parent takes its descendants along
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1, noConversion);
+    BOOST_CHECK(pool.exists(tx1.GetHash()));
+    BOOST_CHECK(!pool.exists(tx3.GetHash()));
+    BOOST_CHECK(!pool.exists(tx4.GetHash()));
+
+    // the minimum only decays after a block, halving every ROLLING_FEE_HALFLIFE while the pool is at least half full
+    int64_t nStartTime = GetTime();
+    SetMockTime(nStartTime);
+    CAmount nMinFee = pool.GetMinFee(1).GetFeePerK();
+    SetMockTime(nStartTime + CTxMemPool::ROLLING_FEE_HALFLIFE);
+    BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), nMinFee);
+
+    std::list<CTransaction> conflicts;
+    pool.removeForBlock(std::vector<CTransaction>(), 1, conflicts, false);
+    SetMockTime(nStartTime + 2 * CTxMemPool::ROLLING_FEE_HALFLIFE);
+    BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), nMinFee / 2);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSizeLimitPrioritiseTest)
+{
+    CTxMemPool pool(CFeeRate(1000));
+    TestMemPoolEntryHelper entry;
+    CCurrencyState noConversion;
+
+    CMutableTransaction tx1 = CMutableTransaction();
+    tx1.vin.resize(1);
+    tx1.vin[0].prevout.n = 1;
+    tx1.vin[0].scriptSig = CScript() << OP_1;
+    tx1.vout.resize(1);
+    tx1.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx1.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx1.GetHash(), entry.Fee(1000LL).FromTx(tx1, &pool));
+
+    CMutableTransaction tx2 = CMutableTransaction();
+    tx2.vin.resize(1);
+    tx2.vin[0].prevout.n = 2;
+    tx2.vin[0].scriptSig = CScript() << OP_2;
+    tx2.vout.resize(1);
+    tx2.vout[0].scriptPubKey = CScript() << OP_2 << OP_EQUAL;
+    tx2.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(5000LL).FromTx(tx2, &pool));
+
+    // a fee delta from prioritisetransaction protects the lower fee transaction
+    pool.PrioritiseTransaction(tx1.GetHash(), tx1.GetHash().GetHex(), 0.0, 10000LL);
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1, noConversion);
+    BOOST_CHECK(pool.exists(tx1.GetHash()));
+    BOOST_CHECK(!pool.exists(tx2.GetHash()));
+
+    // a delta set before the transaction arrives applies once it is added
+    pool.PrioritiseTransaction(tx2.GetHash(), tx2.GetHash().GetHex(), 0.0, 20000LL);
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(5000LL).FromTx(tx2, &pool));
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1, noConversion);
+    BOOST_CHECK(!pool.exists(tx1.GetHash()));
+    BOOST_CHECK(pool.exists(tx2.GetHash()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+// Copyright (c) 2022 The Verus developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "crypto/muhash.h"
+#include "streams.h"
+#include "uint256.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(muhash_tests, BasicTestingSetup)
+
+static MuHash3072 FromInt(unsigned char i)
+{
+    unsigned char data[32] = {0};
+    data[0] = i;
+    MuHash3072 hash;
+    hash.Insert(data, sizeof(data));
+    return hash;
+}
+
+static uint256 Finalized(const MuHash3072 &hash)
+{
+    uint256 out;
+    hash.Finalize(out.begin());
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(muhash_reference_vector)
+{
+    // the same vector as Bitcoin Core, the element encoding is what differs between the two coin set hashes
+    MuHash3072 acc = FromInt(0);
+    acc *= FromInt(1);
+    acc /= FromInt(2);
+    BOOST_CHECK_EQUAL(Finalized(acc).GetHex(), "10d312b100cbd32ada024a6646e40d3482fcff103668d2625f10002a607d5863");
+}
+
+BOOST_AUTO_TEST_CASE(muhash_set_operations)
+{
+    unsigned char data[3][4] = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+
+    MuHash3072 forward, backward;
+    for (int i = 0; i < 3; i++) {
+        forward.Insert(data[i], sizeof(data[i]));
+        backward.Insert(data[2 - i], sizeof(data[2 - i]));
+    }
+    BOOST_CHECK(Finalized(forward) == Finalized(backward));
+
+    // removing an element gives the hash of the set without it, and removing everything gives the empty set
+    MuHash3072 twoElements;
+    twoElements.Insert(data[0], sizeof(data[0])).Insert(data[2], sizeof(data[2]));
+    forward.Remove(data[1], sizeof(data[1]));
+    BOOST_CHECK(Finalized(forward) == Finalized(twoElements));
+    forward.Remove(data[0], sizeof(data[0])).Remove(data[2], sizeof(data[2]));
+    BOOST_CHECK(Finalized(forward) == Finalized(MuHash3072()));
+
+    // an element can be removed before it is inserted
+    MuHash3072 early;
+    early.Remove(data[1], sizeof(data[1]));
+    early.Insert(data[1], sizeof(data[1]));
+    BOOST_CHECK(Finalized(early) == Finalized(MuHash3072()));
+    BOOST_CHECK(Finalized(backward) != Finalized(MuHash3072()));
+}
+
+BOOST_AUTO_TEST_CASE(muhash_serialization)
+{
+    MuHash3072 hash = FromInt(1);
+    hash /= FromInt(2);
+
+    CDataStream ss(SER_DISK, 0);
+    ss << hash;
+    BOOST_CHECK_EQUAL(ss.size(), 2 * Num3072::BYTE_SIZE);
+
+    MuHash3072 loaded;
+    ss >> loaded;
+    BOOST_CHECK(Finalized(loaded) == Finalized(hash));
+
+    // the state keeps working after it is reloaded
+    loaded *= FromInt(2);
+    BOOST_CHECK(Finalized(loaded) == Finalized(FromInt(1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
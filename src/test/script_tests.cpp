@@ -10,8 +10,11 @@
 #include "key.h"
 #include "keystore.h"
 #include "main.h"
+#include "random.h"
+#include "script/cc.h"
 #include "script/script.h"
 #include "script/script_error.h"
+#include "script/serverchecker.h"
 #include "script/sign.h"
 #include "util.h"
 #include "test/test_bitcoin.h"
@@ -988,4 +991,38 @@ BOOST_AUTO_TEST_CASE(script_GetScriptAsm)
     BOOST_CHECK_EQUAL(derSig + "83 " + pubKey, ScriptToAsmStr(CScript() << ToByteVector(ParseHex(derSig + "83")) << vchPubKey));
 }
 
+BOOST_AUTO_TEST_CASE(script_cryptocondition_cache)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    uint256 sighash = GetRandHash();
+    uint256 otherSighash = GetRandHash();
+
+    CC *cond = CCNewSecp256k1(key.GetPubKey());
+    BOOST_CHECK(cc_signTreeSecp256k1Msg32(cond, key.begin(), sighash.begin()) == 1);
+    std::vector<unsigned char> condBinary = CCPubKeyVec(cond);
+    std::vector<unsigned char> ffillBin = CCSigVec(cond);
+
+    CTransaction tx;
+    ServerTransactionSignatureChecker storingChecker(&tx, 0, 0, true);
+    ServerTransactionSignatureChecker checker(&tx, 0, 0, false);
+
+    // a fulfillment verified and cached for one signature hash is not accepted for another
+    BOOST_CHECK(storingChecker.VerifyCryptoConditionSignatures(cond, sighash, condBinary, ffillBin));
+    BOOST_CHECK(!checker.VerifyCryptoConditionSignatures(cond, otherSighash, condBinary, ffillBin));
+    BOOST_CHECK(!storingChecker.VerifyCryptoConditionSignatures(cond, otherSighash, condBinary, ffillBin));
+
+    // nor for another condition
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    CC *otherCond = CCNewSecp256k1(otherKey.GetPubKey());
+    BOOST_CHECK(!checker.VerifyCryptoConditionSignatures(cond, sighash, CCPubKeyVec(otherCond), ffillBin));
+
+    // the cached entry is used up by a check that does not store
+    BOOST_CHECK(checker.VerifyCryptoConditionSignatures(cond, sighash, condBinary, ffillBin));
+
+    cc_free(otherCond);
+    cc_free(cond);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
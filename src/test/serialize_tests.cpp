@@ -417,4 +417,30 @@ BOOST_AUTO_TEST_CASE(class_methods)
     BOOST_CHECK(methodtest3 == methodtest4);
 }
 
+BOOST_AUTO_TEST_CASE(memory_reader)
+{
+    int intval(100);
+    bool boolval(true);
+    std::string stringval("testing");
+    const char* charstrval("testing charstr");
+    CMutableTransaction txval;
+    CSerializeMethodsTestMany methodtest1(intval, boolval, stringval, charstrval, txval);
+    CSerializeMethodsTestMany methodtest2;
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << methodtest1 << intval;
+
+    CMemoryReader reader(&ss[0], &ss[0] + ss.size(), SER_DISK, PROTOCOL_VERSION);
+    reader >> methodtest2;
+    BOOST_CHECK(methodtest1 == methodtest2);
+    BOOST_CHECK_EQUAL(reader.size(), sizeof(intval));
+    reader.ignore(sizeof(intval));
+    BOOST_CHECK(reader.empty());
+
+    // reading past the end of the memory fails rather than reading beyond it
+    BOOST_CHECK_THROW(reader >> intval, std::ios_base::failure);
+    CMemoryReader shortReader(&ss[0], &ss[0] + ss.size() - 1, SER_DISK, PROTOCOL_VERSION);
+    shortReader >> methodtest2;
+    BOOST_CHECK_THROW(shortReader >> intval, std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
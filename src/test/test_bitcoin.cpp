@@ -114,7 +114,10 @@ TestingSetup::TestingSetup()
 #endif
         nScriptCheckThreads = 3;
         for (int i=0; i < nScriptCheckThreads-1; i++)
+        {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadTxPrecomputeCheck);
+        }
         RegisterNodeSignals(GetNodeSignals());
 }
 
@@ -12,6 +12,7 @@
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
 #include "core_io.h"
+#include "core_memusage.h"
 #include "key.h"
 #include "keystore.h"
 #include "main.h"
@@ -857,4 +858,34 @@ BOOST_AUTO_TEST_CASE(test_IsStandardV2)
     BOOST_CHECK(!IsStandardTx(t, reason, false, chainparams));
 }
 
+BOOST_AUTO_TEST_CASE(test_output_descriptors)
+{
+    CMutableTransaction mtx;
+    mtx.vout.resize(2);
+    CKey key;
+    key.MakeNewKey(true);
+    mtx.vout[0].scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+    mtx.vout[1].scriptPubKey = CScript() << OP_RETURN;
+
+    CTransaction tx(mtx);
+    size_t nUnparsedUsage = RecursiveDynamicUsage(tx);
+    const CTxOutDescriptor &desc = tx.GetOutputDescriptor(0);
+    BOOST_CHECK(RecursiveDynamicUsage(tx) > nUnparsedUsage);
+    BOOST_CHECK(!desc.isPayToCC);
+    BOOST_CHECK(!desc.p.IsValid());
+    BOOST_CHECK(!tx.GetOutputDescriptor(1).isPayToCC);
+
+    // outputs are only parsed once, and copies share the result
+    BOOST_CHECK_EQUAL(&tx.GetOutputDescriptor(0), &desc);
+    CTransaction copy(tx);
+    BOOST_CHECK_EQUAL(&copy.GetOutputDescriptor(0), &desc);
+
+    // deserializing replaces them
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << tx;
+    ss >> copy;
+    BOOST_CHECK(&copy.GetOutputDescriptor(0) != &desc);
+    BOOST_CHECK(!copy.GetOutputDescriptor(0).isPayToCC);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,11 +7,16 @@
 
 #include "chainparams.h"
 #include "hash.h"
+#include "init.h"
 #include "main.h"
 #include "pow.h"
 #include "uint256.h"
+#include "ui_interface.h"
 #include "core_io.h"
+#include "compressor.h"
+#include "crypto/muhash.h"
 
+#include <deque>
 #include <stdint.h>
 
 #include <boost/thread.hpp>
@@ -24,17 +29,23 @@ static const char DB_SPROUT_ANCHOR = 'A';
 static const char DB_SAPLING_ANCHOR = 'Z';
 static const char DB_NULLIFIER = 's';
 static const char DB_SAPLING_NULLIFIER = 'S';
-static const char DB_COINS = 'c';
+static const char DB_COINS = 'c';                   // legacy per-transaction CCoins records, upgraded on startup
+static const char DB_COIN = 'C';
+static const char DB_COIN_TX = 'T';
+static const char DB_COIN_STATS = 'M';
+static const char DB_COINS_VERSION = 'V';
 static const char DB_BLOCK_FILES = 'f';
-static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'd';
-static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 'S';
 static const char DB_BLOCKHASHINDEX = 'z';
 static const char DB_SPENTINDEX = 'p';
+static const char DB_CURRENCYSTATEINDEX = 'Y';
+static const char DB_ADDRESSBALANCEINDEX = 'W';
+static const char DB_ADDRESSBALANCEBLOCK = 'w';      // hash and height of the last block applied to the balance index
 static const char DB_BLOCK_INDEX = 'b';
 
-static const char DB_BEST_BLOCK = 'B';
+static const char DB_BEST_BLOCK = 'B';              // best block of legacy coin records, moved to DB_HEAD_BLOCK on upgrade
+static const char DB_HEAD_BLOCK = 'H';
 static const char DB_BEST_SPROUT_ANCHOR = 'a';
 static const char DB_BEST_SAPLING_ANCHOR = 'z';
 static const char DB_FLAG = 'F';
@@ -53,6 +64,162 @@ CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(Get
 {
 }
 
+namespace {
+
+/** Key of one unspent output in the per-output coin store: DB_COIN, txid, VARINT(output index) */
+struct CCoinEntryKey
+{
+    char key;
+    uint256 txid;
+    uint32_t n;
+
+    CCoinEntryKey() : key(DB_COIN), n(0) {}
+    CCoinEntryKey(const uint256 &txidIn, uint32_t nIn) : key(DB_COIN), txid(txidIn), n(nIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(key);
+        READWRITE(txid);
+        READWRITE(VARINT(n));
+    }
+};
+
+/** Value of one unspent output: the transaction level fields of its CCoins record and the compressed output */
+struct CCoinEntryValue
+{
+    int nVersion;
+    int nHeight;
+    bool fCoinBase;
+    CTxOut out;
+
+    CCoinEntryValue() : nVersion(0), nHeight(0), fCoinBase(false) {}
+    CCoinEntryValue(const CCoins &coins, uint32_t n) : nVersion(coins.nVersion), nHeight(coins.nHeight), fCoinBase(coins.fCoinBase), out(coins.vout[n]) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nVersion));
+        unsigned int nCode = ser_action.ForRead() ? 0 : (nHeight * 2 + (fCoinBase ? 1 : 0));
+        READWRITE(VARINT(nCode));
+        if (ser_action.ForRead())
+        {
+            nHeight = nCode >> 1;
+            fCoinBase = nCode & 1;
+        }
+        CTxOutCompressor compressedOut(out);
+        READWRITE(compressedOut);
+    }
+};
+
+/** Record of a transaction with unspent outputs in the per-output coin store: its CCoins fields and the size of its
+ *  output vector, so a lookup is a point read rather than an iterator seek */
+struct CCoinTxValue
+{
+    int nVersion;
+    int nHeight;
+    bool fCoinBase;
+    uint32_t nOutputs;
+
+    CCoinTxValue() : nVersion(0), nHeight(0), fCoinBase(false), nOutputs(0) {}
+    CCoinTxValue(const CCoins &coins, uint32_t nOutputsIn) : nVersion(coins.nVersion), nHeight(coins.nHeight), fCoinBase(coins.fCoinBase), nOutputs(nOutputsIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nVersion));
+        unsigned int nCode = ser_action.ForRead() ? 0 : (nHeight * 2 + (fCoinBase ? 1 : 0));
+        READWRITE(VARINT(nCode));
+        if (ser_action.ForRead())
+        {
+            nHeight = nCode >> 1;
+            fCoinBase = nCode & 1;
+        }
+        READWRITE(VARINT(nOutputs));
+    }
+
+    bool operator==(const CCoinTxValue &other) const {
+        return nVersion == other.nVersion && nHeight == other.nHeight && fCoinBase == other.fCoinBase && nOutputs == other.nOutputs;
+    }
+};
+
+/** Totals and order independent hash of the per-output coin store, updated in the same batch as the outputs */
+struct CCoinStatsRecord
+{
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint64_t nSerializedSize;
+    CAmount nTotalAmount;
+    CCurrencyValueMap reserveAmounts;
+    MuHash3072 muhash;
+
+    CCoinStatsRecord() : nTransactions(0), nTransactionOutputs(0), nSerializedSize(0), nTotalAmount(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nTransactions);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nSerializedSize);
+        READWRITE(nTotalAmount);
+        READWRITE(reserveAmounts);
+        READWRITE(muhash);
+    }
+
+    // each output is hashed as its stored key and value, which also gives its size on disk
+    void Update(const CCoinEntryKey &key, const CCoinEntryValue &value, bool fAdd)
+    {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << key << value;
+        CCurrencyValueMap reserves;
+        if (value.out.scriptPubKey.IsPayToCryptoCondition())
+        {
+            reserves = value.out.ReserveOutValue();
+        }
+        if (fAdd)
+        {
+            muhash.Insert((const unsigned char *)&ss[0], ss.size());
+            nTransactionOutputs++;
+            nSerializedSize += ss.size();
+            nTotalAmount += value.out.nValue;
+            if (reserves.valueMap.size())
+                reserveAmounts += reserves;
+        }
+        else
+        {
+            muhash.Remove((const unsigned char *)&ss[0], ss.size());
+            nTransactionOutputs--;
+            nSerializedSize -= ss.size();
+            nTotalAmount -= value.out.nValue;
+            if (reserves.valueMap.size())
+                reserveAmounts -= reserves;
+        }
+    }
+};
+
+/** Version of the per-output coin store, which also moves the best block to DB_HEAD_BLOCK so that older versions,
+ *  which only know DB_BEST_BLOCK, never treat it as a valid UTXO set */
+static const int COINS_DB_VERSION = 1;
+
+/** Transactions with at most this many outputs are read with point reads, larger ones with one iterator scan */
+static const uint32_t MAX_POINT_READ_OUTPUTS = 16;
+
+/** Positions the cursor at the first output record of txid, returns false if there is none */
+bool SeekCoins(CDBIterator &cursor, const uint256 &txid)
+{
+    CCoinEntryKey entryKey;
+    cursor.Seek(CCoinEntryKey(txid, 0));
+    return cursor.Valid() && cursor.GetKey(entryKey) && entryKey.key == DB_COIN && entryKey.txid == txid;
+}
+
+}
+
 
 bool CCoinsViewDB::GetSproutAnchorAt(const uint256 &rt, SproutMerkleTree &tree) const {
     if (rt == SproutMerkleTree::empty_root()) {
@@ -95,16 +262,47 @@ bool CCoinsViewDB::GetNullifier(const uint256 &nf, ShieldedType type) const {
 }
 
 bool CCoinsViewDB::GetCoins(const uint256 &txid, CCoins &coins) const {
-    return db.Read(make_pair(DB_COINS, txid), coins);
+    CCoinTxValue txValue;
+    if (!db.Read(make_pair(DB_COIN_TX, txid), txValue))
+        return false;
+
+    coins.Clear();
+    coins.fCoinBase = txValue.fCoinBase;
+    coins.nHeight = txValue.nHeight;
+    coins.nVersion = txValue.nVersion;
+    coins.vout.resize(txValue.nOutputs);
+    if (txValue.nOutputs <= MAX_POINT_READ_OUTPUTS) {
+        for (uint32_t i = 0; i < txValue.nOutputs; i++) {
+            CCoinEntryValue entry;
+            if (db.Read(CCoinEntryKey(txid, i), entry))
+                coins.vout[i] = entry.out;
+        }
+    } else {
+        // all unspent outputs of a transaction are adjacent, ordered by output index
+        boost::scoped_ptr<CDBIterator> pcursor(const_cast<CDBWrapper*>(&db)->NewIterator());
+        SeekCoins(*pcursor, txid);
+        CCoinEntryKey entryKey;
+        while (pcursor->Valid() && pcursor->GetKey(entryKey) && entryKey.key == DB_COIN && entryKey.txid == txid) {
+            CCoinEntryValue entry;
+            if (!pcursor->GetValue(entry))
+                return error("CCoinsViewDB::GetCoins() : unable to read output %s:%u", txid.GetHex(), entryKey.n);
+            if (entryKey.n < coins.vout.size())
+                coins.vout[entryKey.n] = entry.out;
+            pcursor->Next();
+        }
+    }
+    if (coins.IsPruned())
+        return error("CCoinsViewDB::GetCoins() : no unspent outputs stored for %s", txid.GetHex());
+    return true;
 }
 
 bool CCoinsViewDB::HaveCoins(const uint256 &txid) const {
-    return db.Exists(make_pair(DB_COINS, txid));
+    return db.Exists(make_pair(DB_COIN_TX, txid));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
     uint256 hashBestChain;
-    if (!db.Read(DB_BEST_BLOCK, hashBestChain))
+    if (!db.Read(DB_HEAD_BLOCK, hashBestChain) && !db.Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
     return hashBestChain;
 }
@@ -171,14 +369,83 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins,
                               CNullifiersMap &mapSproutNullifiers,
                               CNullifiersMap &mapSaplingNullifiers) {
     CDBBatch batch(db);
+    boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
     size_t count = 0;
     size_t changed = 0;
+    size_t outputsWritten = 0;
+
+    // the statistics are only kept once InitStats has computed them, and are dropped if a stored output is unreadable
+    CCoinStatsRecord stats;
+    bool fHaveStats = db.Read(DB_COIN_STATS, stats);
+    bool fStatsValid = fHaveStats;
+
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            if (it->second.coins.IsPruned())
-                batch.Erase(make_pair(DB_COINS, it->first));
-            else
-                batch.Write(make_pair(DB_COINS, it->first), it->second.coins);
+            const CCoins &coins = it->second.coins;
+            std::vector<bool> vOnDisk;
+            size_t nStored = 0, nUnspent = 0;
+            uint32_t nOutputs = 0;
+
+            // only spent outputs are erased and only outputs that are not already stored unchanged are written,
+            // so spending one output of a large transaction is a single deletion. fresh entries have nothing stored.
+            if (!(it->second.flags & CCoinsCacheEntry::FRESH) && SeekCoins(*pcursor, it->first)) {
+                CCoinEntryKey entryKey;
+                while (pcursor->Valid() && pcursor->GetKey(entryKey) && entryKey.key == DB_COIN && entryKey.txid == it->first) {
+                    CCoinEntryValue stored;
+                    bool fReadStored = pcursor->GetValue(stored);
+                    bool fUnchanged = false;
+                    nStored++;
+                    if (entryKey.n >= coins.vout.size() || coins.vout[entryKey.n].IsNull()) {
+                        batch.Erase(entryKey);
+                    } else if (fReadStored &&
+                               stored.nHeight == coins.nHeight &&
+                               stored.nVersion == coins.nVersion &&
+                               stored.fCoinBase == coins.fCoinBase &&
+                               stored.out == coins.vout[entryKey.n]) {
+                        if (vOnDisk.size() <= entryKey.n)
+                            vOnDisk.resize(entryKey.n + 1);
+                        vOnDisk[entryKey.n] = true;
+                        fUnchanged = true;
+                    }
+                    // erased and overwritten outputs leave the set
+                    if (fStatsValid && !fUnchanged) {
+                        if (fReadStored)
+                            stats.Update(entryKey, stored, false);
+                        else
+                            fStatsValid = false;
+                    }
+                    pcursor->Next();
+                }
+            }
+            for (uint32_t i = 0; i < coins.vout.size(); i++) {
+                if (coins.vout[i].IsNull())
+                    continue;
+                nUnspent++;
+                nOutputs = i + 1;
+                if (!(i < vOnDisk.size() && vOnDisk[i])) {
+                    CCoinEntryKey entryKey(it->first, i);
+                    CCoinEntryValue entry(coins, i);
+                    batch.Write(entryKey, entry);
+                    if (fStatsValid)
+                        stats.Update(entryKey, entry, true);
+                    outputsWritten++;
+                }
+            }
+            if (nStored && !nUnspent)
+                stats.nTransactions--;
+            else if (!nStored && nUnspent)
+                stats.nTransactions++;
+
+            // the transaction record is rewritten only when its fields or the size of its outputs change
+            CCoinTxValue storedTx;
+            bool fStoredTx = !(it->second.flags & CCoinsCacheEntry::FRESH) && db.Read(make_pair(DB_COIN_TX, it->first), storedTx);
+            if (nUnspent) {
+                CCoinTxValue txValue(coins, nOutputs);
+                if (!fStoredTx || !(storedTx == txValue))
+                    batch.Write(make_pair(DB_COIN_TX, it->first), txValue);
+            } else if (fStoredTx) {
+                batch.Erase(make_pair(DB_COIN_TX, it->first));
+            }
             changed++;
         }
         count++;
@@ -193,13 +460,22 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins,
     ::BatchWriteNullifiers(batch, mapSaplingNullifiers, DB_SAPLING_NULLIFIER);
 
     if (!hashBlock.IsNull())
-        batch.Write(DB_BEST_BLOCK, hashBlock);
+        batch.Write(DB_HEAD_BLOCK, hashBlock);
     if (!hashSproutAnchor.IsNull())
         batch.Write(DB_BEST_SPROUT_ANCHOR, hashSproutAnchor);
     if (!hashSaplingAnchor.IsNull())
         batch.Write(DB_BEST_SAPLING_ANCHOR, hashSaplingAnchor);
 
-    LogPrint("coindb", "Committing %u changed transactions (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
+    if (fStatsValid) {
+        if (!hashBlock.IsNull())
+            stats.hashBlock = hashBlock;
+        batch.Write(DB_COIN_STATS, stats);
+    } else if (fHaveStats) {
+        LogPrintf("%s: unable to read a spent output, UTXO set statistics will be recomputed on restart\n", __func__);
+        batch.Erase(DB_COIN_STATS);
+    }
+
+    LogPrint("coindb", "Committing %u changed transactions (out of %u, %u new outputs) to coin database...\n", (unsigned int)changed, (unsigned int)count, (unsigned int)outputsWritten);
     return db.WriteBatch(batch);
 }
 
@@ -226,52 +502,203 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read(DB_LAST_BLOCK, nFile);
 }
 
+// computes the statistics of the stored outputs, and if pss is set, the serialized hash of the set in key order. the
+// outputs are grouped back into their transactions for that hash, so it is the same as for the per-transaction
+// records this store replaced.
+static bool ScanCoinStats(CDBWrapper &db, CCoinStatsRecord &stats, CHashWriter *pss)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(CCoinEntryKey(uint256(), 0));
+
+    uint256 prevTxid;
+    bool fInTx = false;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        if (ShutdownRequested()) {
+            return false;
+        }
+        CCoinEntryKey entryKey;
+        CCoinEntryValue entry;
+        if (!pcursor->GetKey(entryKey) || entryKey.key != DB_COIN) {
+            break;
+        }
+        if (!pcursor->GetValue(entry)) {
+            return error("%s: unable to read value", __func__);
+        }
+        if (!fInTx || entryKey.txid != prevTxid) {
+            if (pss && fInTx)
+                *pss << VARINT(0);
+            prevTxid = entryKey.txid;
+            fInTx = true;
+            stats.nTransactions++;
+        }
+        if (pss) {
+            *pss << VARINT(entryKey.n + 1);
+            *pss << entry.out;
+        }
+        stats.Update(entryKey, entry, true);
+        pcursor->Next();
+    }
+    if (pss && fInTx)
+        *pss << VARINT(0);
+    return true;
+}
+
+static void SetCoinsStats(CCoinsStats &stats, const CCoinStatsRecord &record)
+{
+    stats.hashBlock = record.hashBlock;
+    stats.nTransactions = record.nTransactions;
+    stats.nTransactionOutputs = record.nTransactionOutputs;
+    stats.nSerializedSize = record.nSerializedSize;
+    stats.nTotalAmount = record.nTotalAmount;
+    stats.reserveAmounts = record.reserveAmounts;
+    record.muhash.Finalize(stats.hashMuHash.begin());
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(stats.hashBlock);
+        stats.nHeight = mi != mapBlockIndex.end() ? mi->second->GetHeight() : 0;
+    }
+}
+
 bool CCoinsViewDB::GetStats(CCoinsStats &stats) const {
+    // the record is written in the same batch as the best block, so it always describes the stored set
+    CCoinStatsRecord record;
+    if (!db.Read(DB_COIN_STATS, record)) {
+        return ScanStats(stats);
+    }
+    SetCoinsStats(stats, record);
+    return true;
+}
+
+bool CCoinsViewDB::ScanStats(CCoinsStats &stats) const {
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    CCoinStatsRecord record;
+    record.hashBlock = GetBestBlock();
+    ss << record.hashBlock;
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
        that restriction.  */
-    boost::scoped_ptr<CDBIterator> pcursor(const_cast<CDBWrapper*>(&db)->NewIterator());
-    pcursor->Seek(DB_COINS);
+    if (!ScanCoinStats(const_cast<CDBWrapper&>(db), record, &ss)) {
+        return false;
+    }
+    SetCoinsStats(stats, record);
+    stats.hashSerialized = ss.GetHash();
+    return true;
+}
 
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = GetBestBlock();
-    ss << stats.hashBlock;
-    CAmount nTotalAmount = 0;
+bool CCoinsViewDB::Upgrade() {
+    int nVersion = 0;
+    bool fHaveVersion = db.Read(DB_COINS_VERSION, nVersion);
+    if (fHaveVersion && nVersion > COINS_DB_VERSION) {
+        return error("CCoinsViewDB::Upgrade() : chainstate database version %d was written by a newer version", nVersion);
+    }
+
+    boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(make_pair(DB_COINS, uint256()));
+    std::pair<char, uint256> key;
+    bool fLegacyCoins = pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_COINS;
+
+    // an older version run on an upgraded database finds no best block and connects the chain again into legacy
+    // records, which leaves a mix of both layouts
+    if ((fHaveVersion || db.Exists(DB_HEAD_BLOCK)) && db.Exists(DB_BEST_BLOCK)) {
+        return error("CCoinsViewDB::Upgrade() : chainstate database was modified by an older version, -reindex is required");
+    }
+    if (fHaveVersion && fLegacyCoins) {
+        return error("CCoinsViewDB::Upgrade() : chainstate database has legacy coin records, -reindex is required");
+    }
+
+    CDBBatch batch(db);
+    uint256 hashBestChain;
+    if (db.Read(DB_BEST_BLOCK, hashBestChain)) {
+        batch.Write(DB_HEAD_BLOCK, hashBestChain);
+        batch.Erase(DB_BEST_BLOCK);
+    }
+
+    if (!fLegacyCoins) {
+        if (fHaveVersion) {
+            return true;
+        }
+        batch.Write(DB_COINS_VERSION, COINS_DB_VERSION);
+        return db.WriteBatch(batch);
+    }
+
+    LogPrintf("Upgrading chainstate database to per-output coin records...\n");
+    uiInterface.InitMessage(_("Upgrading UTXO database"));
+
+    static const size_t UPGRADE_BATCH_ENTRIES = 100000;
+    // the upgraded outputs are not counted, so statistics are recomputed afterwards
+    batch.Erase(DB_COIN_STATS);
+    size_t nBatchEntries = 0;
+    size_t nTransactions = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
+        if (ShutdownRequested()) {
+            break;
+        }
+        if (!pcursor->GetKey(key) || key.first != DB_COINS) {
+            break;
+        }
         CCoins coins;
-        if (pcursor->GetKey(key) && key.first == DB_COINS) {
-            if (pcursor->GetValue(coins)) {
-                stats.nTransactions++;
-                for (unsigned int i=0; i<coins.vout.size(); i++) {
-                    const CTxOut &out = coins.vout[i];
-                    if (!out.IsNull()) {
-                        stats.nTransactionOutputs++;
-                        ss << VARINT(i+1);
-                        ss << out;
-                        nTotalAmount += out.nValue;
-                    }
-                }
-                stats.nSerializedSize += 32 + pcursor->GetValueSize();
-                ss << VARINT(0);
-            } else {
-                return error("CCoinsViewDB::GetStats() : unable to read value");
+        if (!pcursor->GetValue(coins)) {
+            return error("CCoinsViewDB::Upgrade() : unable to read coins for %s", key.second.GetHex());
+        }
+        uint32_t nOutputs = 0;
+        for (uint32_t i = 0; i < coins.vout.size(); i++) {
+            if (!coins.vout[i].IsNull()) {
+                batch.Write(CCoinEntryKey(key.second, i), CCoinEntryValue(coins, i));
+                nBatchEntries++;
+                nOutputs = i + 1;
             }
-        } else {
-            break;
+        }
+        if (nOutputs) {
+            batch.Write(make_pair(DB_COIN_TX, key.second), CCoinTxValue(coins, nOutputs));
+            nBatchEntries++;
+        }
+        batch.Erase(key);
+        nBatchEntries++;
+        nTransactions++;
+
+        // the old record is erased in the same batch that writes its outputs, so an interrupted upgrade
+        // resumes where it stopped on the next start
+        if (nBatchEntries >= UPGRADE_BATCH_ENTRIES) {
+            if (!db.WriteBatch(batch)) {
+                return false;
+            }
+            batch.Clear();
+            nBatchEntries = 0;
+            LogPrintf("Upgraded %u transactions in chainstate database\n", (unsigned int)nTransactions);
         }
         pcursor->Next();
     }
-    {
-        LOCK(cs_main);
-        stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->GetHeight();
+    // the version is only written once every legacy record is converted, and an interruption is not an error
+    if (!ShutdownRequested()) {
+        batch.Write(DB_COINS_VERSION, COINS_DB_VERSION);
     }
-    stats.hashSerialized = ss.GetHash();
-    stats.nTotalAmount = nTotalAmount;
+    if (!db.WriteBatch(batch)) {
+        return false;
+    }
+    LogPrintf("Upgraded %u transactions in chainstate database%s\n", (unsigned int)nTransactions, ShutdownRequested() ? ", interrupted" : "");
     return true;
 }
 
+bool CCoinsViewDB::InitStats() {
+    if (db.Exists(DB_COIN_STATS)) {
+        return true;
+    }
+
+    LogPrintf("Computing UTXO set statistics...\n");
+    uiInterface.InitMessage(_("Computing UTXO set statistics..."));
+
+    CCoinStatsRecord stats;
+    stats.hashBlock = GetBestBlock();
+    if (!ScanCoinStats(db, stats, NULL)) {
+        return false;
+    }
+
+    LogPrintf("Computed UTXO set statistics for %u outputs\n", (unsigned int)stats.nTransactionOutputs);
+    return db.Write(DB_COIN_STATS, stats);
+}
+
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
@@ -332,12 +759,25 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<CAddressUnspentDb
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::vector<CAddressUnspentDbEntry> &unspentOutputs)
+{
+    return ReadAddressUnspentIndexPage(addressHash, type, nullptr, SIZE_MAX, unspentOutputs);
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndexPage(uint160 addressHash, int type, const CAddressUnspentKey *after, size_t maxEntries, std::vector<CAddressUnspentDbEntry> &unspentOutputs)
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (after) {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, *after));
+        pair<char, CAddressUnspentKey> keyObj;
+        if (pcursor->Valid() && pcursor->GetKey(keyObj) && keyObj.first == DB_ADDRESSUNSPENTINDEX && keyObj.second == *after) {
+            pcursor->Next();
+        }
+    } else {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
-    while (pcursor->Valid()) {
+    for (size_t nRead = 0; nRead < maxEntries && pcursor->Valid(); nRead++) {
         boost::this_thread::interruption_point();
         try {
             CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -365,6 +805,11 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::v
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressUnspentValue(const CAddressUnspentKey &key, CAddressUnspentValue &value)
+{
+    return Read(make_pair(DB_ADDRESSUNSPENTINDEX, key), value);
+}
+
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<CAddressIndexDbEntry> &vect) {
     CDBBatch batch(*this);
     for (std::vector<CAddressIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++)
@@ -383,16 +828,31 @@ bool CBlockTreeDB::ReadAddressIndex(
         uint160 addressHash, int type,
         std::vector<CAddressIndexDbEntry> &addressIndex,
         int start, int end)
+{
+    return ReadAddressIndexPage(addressHash, type, nullptr, SIZE_MAX, addressIndex, start, end);
+}
+
+bool CBlockTreeDB::ReadAddressIndexPage(
+        uint160 addressHash, int type,
+        const CAddressIndexKey *after, size_t maxEntries,
+        std::vector<CAddressIndexDbEntry> &addressIndex,
+        int start, int end)
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
+    if (after) {
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, *after));
+        pair<char, CAddressIndexKey> keyObj;
+        if (pcursor->Valid() && pcursor->GetKey(keyObj) && keyObj.first == DB_ADDRESSINDEX && keyObj.second == *after) {
+            pcursor->Next();
+        }
+    } else if (start > 0 && end > 0) {
         pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
     }
 
-    while (pcursor->Valid()) {
+    for (size_t nRead = 0; nRead < maxEntries && pcursor->Valid(); nRead++) {
         boost::this_thread::interruption_point();
         try {
             pair<char, CAddressIndexKey> keyObj;
@@ -424,6 +884,54 @@ bool CBlockTreeDB::ReadAddressIndex(
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressIndexReverse(
+        uint160 addressHash, int type,
+        const boost::function<bool(const CAddressIndexDbEntry &)> &visit,
+        int start, int end)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    // seek past the end of the range and walk back, so only the entries that are visited are read
+    int lowest = (start > 0 && end > 0) ? start : 0;
+    if (end > 0 && end < INT32_MAX) {
+        pcursor->SeekBefore(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, end + 1)));
+    } else {
+        pcursor->SeekBefore(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, INT32_MAX)));
+    }
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        try {
+            pair<char, CAddressIndexKey> keyObj;
+            pcursor->GetKey(keyObj);
+            char chType = keyObj.first;
+            CAddressIndexKey indexKey = keyObj.second;
+
+            if (chType == DB_ADDRESSINDEX && indexKey.type == type && indexKey.hashBytes == addressHash) {
+                if (indexKey.blockHeight < lowest) {
+                    break;
+                }
+                CAmount nValue;
+                try {
+                    pcursor->GetValue(nValue);
+                } catch (const std::exception& e) {
+                    return error("failed to get address index value");
+                }
+                if (!visit(make_pair(indexKey, nValue))) {
+                    break;
+                }
+                pcursor->Prev();
+            } else {
+                break;
+            }
+        } catch (const std::exception& e) {
+            break;
+        }
+    }
+
+    return true;
+}
+
 bool getAddressFromIndex(const int &type, const uint160 &hash, std::string &address);
 
 UniValue CBlockTreeDB::Snapshot(int top)
@@ -560,6 +1068,87 @@ UniValue CBlockTreeDB::Snapshot(int top)
     return(result);
 }
 
+bool CBlockTreeDB::UpdateAddressBalanceIndex(const std::vector<CAddressBalanceDbEntry> &vect, bool fConnect, const uint256 &hashBlock, int nHeight) {
+    CDBBatch batch(*this);
+    batch.Write(DB_ADDRESSBALANCEBLOCK, std::make_pair(hashBlock, nHeight));
+    for (std::vector<CAddressBalanceDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        CAddressBalanceValue value;
+        if (Exists(make_pair(DB_ADDRESSBALANCEINDEX, it->first)) && !Read(make_pair(DB_ADDRESSBALANCEINDEX, it->first), value))
+            return error("failed to read address balance index value");
+        value.Apply(it->second, fConnect);
+        if (value.IsNull()) {
+            batch.Erase(make_pair(DB_ADDRESSBALANCEINDEX, it->first));
+        } else {
+            batch.Write(make_pair(DB_ADDRESSBALANCEINDEX, it->first), value);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressBalanceBlock(uint256 &hashBlock, int &nHeight) {
+    std::pair<uint256, int> applied;
+    if (!Exists(DB_ADDRESSBALANCEBLOCK)) {
+        hashBlock.SetNull();
+        nHeight = 0;
+        return true;
+    }
+    if (!Read(DB_ADDRESSBALANCEBLOCK, applied))
+        return false;
+    hashBlock = applied.first;
+    nHeight = applied.second;
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressBalance(const CAddressBalanceKey &key, CAddressBalanceValue &value) {
+    value.SetNull();
+    return !Exists(make_pair(DB_ADDRESSBALANCEINDEX, key)) || Read(make_pair(DB_ADDRESSBALANCEINDEX, key), value);
+}
+
+bool CBlockTreeDB::WriteCurrencyStateIndex(const std::vector<CCurrencyStateIndexDbEntry> &vect) {
+    CDBBatch batch(*this);
+    for (std::vector<CCurrencyStateIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Write(make_pair(DB_CURRENCYSTATEINDEX, it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseCurrencyStateIndex(const std::vector<CCurrencyStateIndexDbEntry> &vect) {
+    CDBBatch batch(*this);
+    for (std::vector<CCurrencyStateIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Erase(make_pair(DB_CURRENCYSTATEINDEX, it->first));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadLastCurrencyState(const uint160 &currencyID, int start, int end, CCurrencyStateIndexDbEntry &entry)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    // seek past the end of the range, then step back to the last entry in it
+    int lowest = (start > 0 && end > 0) ? start : 0;
+    if (end > 0 && end < INT32_MAX) {
+        pcursor->SeekBefore(make_pair(DB_CURRENCYSTATEINDEX, CCurrencyStateIndexKey(currencyID, end + 1)));
+    } else {
+        pcursor->SeekBefore(make_pair(DB_CURRENCYSTATEINDEX, CCurrencyStateIndexKey(currencyID, UINT32_MAX)));
+    }
+    if (!pcursor->Valid()) {
+        return false;
+    }
+
+    try {
+        pair<char, CCurrencyStateIndexKey> keyObj;
+        if (!pcursor->GetKey(keyObj) ||
+            keyObj.first != DB_CURRENCYSTATEINDEX ||
+            keyObj.second.currencyID != currencyID ||
+            (int64_t)keyObj.second.blockHeight < lowest ||
+            !pcursor->GetValue(entry.second)) {
+            return false;
+        }
+        entry.first = keyObj.second;
+    } catch (const std::exception& e) {
+        return error("failed to get currency state index value");
+    }
+    return true;
+}
+
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -642,77 +1231,196 @@ bool CBlockTreeDB::blockOnchainActive(const uint256 &hash) {
     return true;
 }
 
+namespace {
+
+// block index records verified by the loader threads, handed to the thread that adds them to the block index
+class CBlockIndexLoadQueue
+{
+public:
+    typedef std::vector<std::pair<uint256, CDiskBlockIndex>> Chunk;
+
+    CBlockIndexLoadQueue(int nWorkers, size_t nMaxChunks) : nRunning(nWorkers), nMaxQueued(nMaxChunks), fAbort(false) {}
+
+    // false if the load is being aborted, in which case the worker should stop
+    bool Push(Chunk &chunk)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fAbort && chunks.size() >= nMaxQueued)
+            condSpace.wait(lock);
+        if (fAbort)
+            return false;
+        chunks.push_back(Chunk());
+        chunks.back().swap(chunk);
+        condData.notify_one();
+        return true;
+    }
+
+    // false once all workers are done and the queue is empty
+    bool Pop(Chunk &chunk)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fAbort && chunks.empty() && nRunning)
+            condData.wait(lock);
+        if (fAbort || chunks.empty())
+            return false;
+        chunk.swap(chunks.front());
+        chunks.pop_front();
+        condSpace.notify_one();
+        return true;
+    }
+
+    void WorkerDone(const std::string &error=std::string())
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nRunning--;
+        if (!error.empty() && strError.empty())
+        {
+            strError = error;
+            fAbort = true;
+            condSpace.notify_all();
+        }
+        condData.notify_all();
+    }
+
+    void Abort()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fAbort = true;
+        condSpace.notify_all();
+        condData.notify_all();
+    }
+
+    std::string GetError()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return strError;
+    }
+
+private:
+    boost::mutex mutex;
+    boost::condition_variable condData;
+    boost::condition_variable condSpace;
+    std::deque<Chunk> chunks;
+    int nRunning;
+    size_t nMaxQueued;
+    bool fAbort;
+    std::string strError;
+};
+
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    static const int MAX_LOAD_THREADS = 8;
+    static const size_t LOAD_CHUNK_SIZE = 1000;
 
-    pcursor->Seek(make_pair(DB_BLOCK_INDEX, uint256()));
+    // records are keyed by block hash, so keys are evenly spread and each loader thread reads and deserializes the
+    // records whose keys start with its range of first bytes, and computes their block hashes, which is most of the
+    // work. this thread links the records into the block index as they arrive.
+    int nThreads = std::max(1, std::min(GetNumCores(), MAX_LOAD_THREADS));
+    CBlockIndexLoadQueue queue(nThreads, nThreads * 2);
 
-    // Load mapBlockIndex
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
+    auto loadRange = [this, &queue](unsigned int firstByte, unsigned int endByte)
+    {
+        try {
+            boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+            uint256 startKey;
+            *startKey.begin() = firstByte;
+            pcursor->Seek(make_pair(DB_BLOCK_INDEX, startKey));
+
+            CBlockIndexLoadQueue::Chunk chunk;
+            while (pcursor->Valid()) {
+                std::pair<char, uint256> key;
+                if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX || *key.second.begin() >= endByte)
+                    break;
+                CDiskBlockIndex diskindex;
+                if (!pcursor->GetValue(diskindex)) {
+                    queue.WorkerDone("failed to read value");
+                    return;
+                }
 #ifdef VERUSHASHDEBUG
                 if (diskindex.nVersion == CBlockHeader::VERUS_V2)
                 {
                     printf("VerusHash 2.0 block header: %s\n", diskindex.ToString().c_str());
                 }
 #endif
-                CBlockIndex* pindexNew    = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->SetHeight(diskindex.GetHeight());
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->hashSproutAnchor     = diskindex.hashSproutAnchor;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->hashFinalSaplingRoot   = diskindex.hashFinalSaplingRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nSolution      = diskindex.nSolution;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nCachedBranchId = diskindex.nCachedBranchId;
-                pindexNew->nTx            = diskindex.nTx;
-                pindexNew->nSproutValue   = diskindex.nSproutValue;
-                pindexNew->nSaplingValue  = diskindex.nSaplingValue;
-
-                // Consistency checks
-                auto header = pindexNew->GetBlockHeader();
-                uint256 hash = header.GetHash();
+                uint256 hash = diskindex.GetBlockHash();
                 if (diskindex.hashPrev.IsNull() && hash != Params().consensus.hashGenesisBlock)
                 {
-                    return error("LoadBlockIndex(): prior block hash NULL on non-genesis block: %s\n", diskindex.ToString());
-                }
-
-                if (hash != pindexNew->GetBlockHash())
-                {
-                    printf("Error -- hashes don't match.\nheader.GetHash: %s\nGetBlockHash(): %s\non disk: %s\nin memory: %s\n",
-                           hash.GetHex().c_str(), pindexNew->GetBlockHash().GetHex().c_str(), diskindex.ToString().c_str(),  pindexNew->ToString().c_str());
-                    return error("LoadBlockIndex(): block header inconsistency detected: on-disk = %s, in-memory = %s",
-                                 diskindex.ToString(),  pindexNew->ToString());
+                    queue.WorkerDone(strprintf("prior block hash NULL on non-genesis block: %s", diskindex.ToString()));
+                    return;
                 }
-
-                if ( 0 ) // POW will be checked before any block is connected
-                {
-                    uint8_t pubkey33[33];
-                    komodo_index2pubkey33(pubkey33,pindexNew,pindexNew->GetHeight());
-                    if (!CheckProofOfWork(header,pubkey33,pindexNew->GetHeight(),Params().GetConsensus()))
-                        return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
+                chunk.push_back(std::make_pair(hash, std::move(diskindex)));
+                if (chunk.size() >= LOAD_CHUNK_SIZE && !queue.Push(chunk)) {
+                    queue.WorkerDone();
+                    return;
                 }
                 pcursor->Next();
-            } else {
-                return error("LoadBlockIndex() : failed to read value");
             }
-        } else {
-            break;
+            if (!chunk.empty())
+                queue.Push(chunk);
+            queue.WorkerDone();
+        } catch (const std::exception& e) {
+            queue.WorkerDone(e.what());
         }
+    };
+
+    boost::thread_group loaders;
+    for (int i = 0; i < nThreads; i++) {
+        unsigned int firstByte = (i * 256) / nThreads, endByte = ((i + 1) * 256) / nThreads;
+        loaders.create_thread([&loadRange, firstByte, endByte]() { loadRange(firstByte, endByte); });
+    }
+
+    // stop the loaders if this thread is interrupted or fails
+    struct CLoaderGuard {
+        CBlockIndexLoadQueue &queue;
+        boost::thread_group &loaders;
+        ~CLoaderGuard() { queue.Abort(); loaders.join_all(); }
+    } loaderGuard = {queue, loaders};
+
+    // Load mapBlockIndex
+    CBlockIndexLoadQueue::Chunk chunk;
+    while (queue.Pop(chunk)) {
+        boost::this_thread::interruption_point();
+        for (auto &entry : chunk) {
+            CDiskBlockIndex &diskindex = entry.second;
+
+            // Construct block index object. the block hash is computed from these same fields, so the header rebuilt
+            // from the new index always hashes to the hash it is stored under
+            CBlockIndex* pindexNew    = insertBlockIndex(entry.first);
+            pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
+            pindexNew->SetHeight(diskindex.GetHeight());
+            pindexNew->nFile          = diskindex.nFile;
+            pindexNew->nDataPos       = diskindex.nDataPos;
+            pindexNew->nUndoPos       = diskindex.nUndoPos;
+            pindexNew->hashSproutAnchor     = diskindex.hashSproutAnchor;
+            pindexNew->nVersion       = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->hashFinalSaplingRoot   = diskindex.hashFinalSaplingRoot;
+            pindexNew->nTime          = diskindex.nTime;
+            pindexNew->nBits          = diskindex.nBits;
+            pindexNew->nNonce         = diskindex.nNonce;
+            pindexNew->nSolution      = std::move(diskindex.nSolution);
+            pindexNew->nStatus        = diskindex.nStatus;
+            pindexNew->nCachedBranchId = diskindex.nCachedBranchId;
+            pindexNew->nTx            = diskindex.nTx;
+            pindexNew->nSproutValue   = diskindex.nSproutValue;
+            pindexNew->nSaplingValue  = diskindex.nSaplingValue;
+            pindexNew->newcoins       = diskindex.newcoins;
+            pindexNew->zfunds         = diskindex.zfunds;
+            pindexNew->immature       = diskindex.immature;
+            pindexNew->maturity       = diskindex.maturity;
+            pindexNew->nChainTransparentSupply = diskindex.nChainTransparentSupply;
+            pindexNew->nChainShieldedSupply = diskindex.nChainShieldedSupply;
+            pindexNew->nChainImmatureSupply = diskindex.nChainImmatureSupply;
+            pindexNew->pChainCurrencySupply = diskindex.pChainCurrencySupply;
+        }
+        chunk.clear();
     }
 
+    std::string strError = queue.GetError();
+    if (!strError.empty())
+        return error("LoadBlockIndex(): %s", strError);
+
     return true;
 }
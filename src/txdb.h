@@ -17,12 +17,17 @@
 #include <univalue.h>
 
 #include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
 
 class CBlockIndex;
 struct CDiskTxPos;
 struct CAddressUnspentKey;
 struct CAddressUnspentValue;
 struct CAddressIndexKey;
+struct CCurrencyStateIndexKey;
+struct CAddressBalanceKey;
+struct CAddressBalanceValue;
 struct CAddressIndexIteratorKey;
 struct CAddressIndexIteratorHeightKey;
 struct CSpentIndexKey;
@@ -32,8 +37,14 @@ struct CTimestampIndexIteratorKey;
 struct CTimestampBlockIndexKey;
 struct CTimestampBlockIndexValue;
 
+//! Key prefixes of the block tree indexes whose records are upgraded in place in the background
+static const char DB_TXINDEX = 't';
+static const char DB_ADDRESSUNSPENTINDEX = 'u';
+
 typedef std::pair<CAddressUnspentKey, CAddressUnspentValue> CAddressUnspentDbEntry;
 typedef std::pair<CAddressIndexKey, CAmount> CAddressIndexDbEntry;
+typedef std::pair<CCurrencyStateIndexKey, std::vector<unsigned char>> CCurrencyStateIndexDbEntry;
+typedef std::pair<CAddressBalanceKey, CAddressBalanceValue> CAddressBalanceDbEntry;
 typedef std::pair<CSpentIndexKey, CSpentIndexValue> CSpentIndexDbEntry;
 
 class uint256;
@@ -48,16 +59,30 @@ static const int64_t nMinDbCache = 4;
 struct CDiskTxPos : public CDiskBlockPos
 {
     unsigned int nTxOffset; // after header
+    uint256 blockHash;      // null in records written before the block hash was stored
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        ::Serialize(s, *(CDiskBlockPos*)this);
+        ::Serialize(s, VARINT(nTxOffset));
+        if (!blockHash.IsNull()) {
+            ::Serialize(s, blockHash);
+        }
+    }
 
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(*(CDiskBlockPos*)this);
-        READWRITE(VARINT(nTxOffset));
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        ::Unserialize(s, *(CDiskBlockPos*)this);
+        ::Unserialize(s, VARINT(nTxOffset));
+        if (s.empty()) {
+            blockHash.SetNull();
+        } else {
+            ::Unserialize(s, blockHash);
+        }
     }
 
-    CDiskTxPos(const CDiskBlockPos &blockIn, unsigned int nTxOffsetIn) : CDiskBlockPos(blockIn.nFile, blockIn.nPos), nTxOffset(nTxOffsetIn) {
+    CDiskTxPos(const CDiskBlockPos &blockIn, unsigned int nTxOffsetIn, const uint256 &blockHashIn=uint256()) :
+        CDiskBlockPos(blockIn.nFile, blockIn.nPos), nTxOffset(nTxOffsetIn), blockHash(blockHashIn) {
     }
 
     CDiskTxPos() {
@@ -67,6 +92,7 @@ struct CDiskTxPos : public CDiskBlockPos
     void SetNull() {
         CDiskBlockPos::SetNull();
         nTxOffset = 0;
+        blockHash.SetNull();
     }
 };
 
@@ -94,7 +120,16 @@ public:
                     CAnchorsSaplingMap &mapSaplingAnchors,
                     CNullifiersMap &mapSproutNullifiers,
                     CNullifiersMap &mapSaplingNullifiers);
+    //! Read the running statistics of the coin store, or scan it if they are not being kept
     bool GetStats(CCoinsStats &stats) const;
+    //! Scan the coin store for its statistics and serialized hash, whether or not running statistics are kept
+    bool ScanStats(CCoinsStats &stats) const;
+
+    //! Convert legacy per-transaction coin records to per-output records, resuming any interrupted conversion. Fails
+    //! for a database that an older version has written to since it was converted.
+    bool Upgrade();
+    //! Compute the running statistics of the coin store if it has none, after which every batch keeps them up to date
+    bool InitStats();
 };
 
 /** Access to the block database (blocks/index/) */
@@ -118,15 +153,69 @@ public:
     bool UpdateSpentIndex(const std::vector<CSpentIndexDbEntry> &vect);
     bool UpdateAddressUnspentIndex(const std::vector<CAddressUnspentDbEntry> &vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, int type, std::vector<CAddressUnspentDbEntry> &vect);
+    //! Read at most maxEntries of an address's unspent index records, continuing after the key after if it is not null
+    bool ReadAddressUnspentIndexPage(uint160 addressHash, int type, const CAddressUnspentKey *after, size_t maxEntries, std::vector<CAddressUnspentDbEntry> &vect);
+    bool ReadAddressUnspentValue(const CAddressUnspentKey &key, CAddressUnspentValue &value);
     bool WriteAddressIndex(const std::vector<CAddressIndexDbEntry> &vect);
     bool EraseAddressIndex(const std::vector<CAddressIndexDbEntry> &vect);
     bool ReadAddressIndex(uint160 addressHash, int type, std::vector<CAddressIndexDbEntry> &addressIndex, int start = 0, int end = 0);
+    //! Read at most maxEntries of ReadAddressIndex's entries, continuing after the key after if it is not null
+    bool ReadAddressIndexPage(uint160 addressHash, int type, const CAddressIndexKey *after, size_t maxEntries, std::vector<CAddressIndexDbEntry> &addressIndex, int start = 0, int end = 0);
+    //! Visit the entries of ReadAddressIndex from the newest, until visit returns false
+    bool ReadAddressIndexReverse(uint160 addressHash, int type, const boost::function<bool(const CAddressIndexDbEntry &)> &visit, int start = 0, int end = 0);
+    //! Add the balance changes of a connected block to the balance index, or remove those of a disconnected one, and
+    //! record in the same batch the block that the index is now at
+    bool UpdateAddressBalanceIndex(const std::vector<CAddressBalanceDbEntry> &vect, bool fConnect, const uint256 &hashBlock, int nHeight);
+    //! Read the last block applied to the balance index, which is null if none has been recorded
+    bool ReadAddressBalanceBlock(uint256 &hashBlock, int &nHeight);
+    bool ReadAddressBalance(const CAddressBalanceKey &key, CAddressBalanceValue &value);
+    bool WriteCurrencyStateIndex(const std::vector<CCurrencyStateIndexDbEntry> &vect);
+    bool EraseCurrencyStateIndex(const std::vector<CCurrencyStateIndexDbEntry> &vect);
+    //! Read the last indexed notarization of a currency in a height range, with the same range rules as ReadAddressIndex
+    bool ReadLastCurrencyState(const uint160 &currencyID, int start, int end, CCurrencyStateIndexDbEntry &entry);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &vect);
     bool WriteTimestampBlockIndex(const CTimestampBlockIndexKey &blockhashIndex, const CTimestampBlockIndexValue &logicalts);
     bool ReadTimestampBlockIndex(const uint256 &hash, unsigned int &logicalTS);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+
+    //! Read up to maxEntries records with key prefix chPrefix after start, that fUpgraded does not accept
+    template <typename K, typename V>
+    bool ReadRecordsToUpgrade(char chPrefix, const K &start, size_t maxEntries, const boost::function<bool(const V &)> &fUpgraded, std::vector<std::pair<K, V> > &vect)
+    {
+        boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+        pcursor->Seek(std::make_pair(chPrefix, start));
+
+        while (pcursor->Valid() && vect.size() < maxEntries) {
+            boost::this_thread::interruption_point();
+            std::pair<char, K> keyObj;
+            if (!pcursor->GetKey(keyObj) || keyObj.first != chPrefix) {
+                break;
+            }
+            V value;
+            if (!pcursor->GetValue(value)) {
+                return error("failed to get index value for upgrade");
+            }
+            if (!fUpgraded(value) && !(keyObj.second == start)) {
+                vect.push_back(std::make_pair(keyObj.second, value));
+            }
+            pcursor->Next();
+        }
+        return true;
+    }
+
+    //! Write records with key prefix chPrefix in one batch
+    template <typename K, typename V>
+    bool WriteRecords(char chPrefix, const std::vector<std::pair<K, V> > &vect)
+    {
+        CDBBatch batch(*this);
+        for (auto &oneRecord : vect)
+            batch.Write(std::make_pair(chPrefix, oneRecord.first), oneRecord.second);
+        return WriteBatch(batch);
+    }
+
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
     bool blockOnchainActive(const uint256 &hash);
     UniValue Snapshot(int top);
@@ -21,6 +21,8 @@
 #include "pbaas/identity.h"
 #include "pbaas/notarization.h"
 
+#include <cmath>
+
 using namespace std;
 
 CTxMemPoolEntry::CTxMemPoolEntry():
@@ -40,6 +42,11 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransaction& _tx, const CAmount& _nFee,
 {
     nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
     nModSize = _tx.CalculateModifiedSize(nTxSize);
+    // validation and the miner parse the outputs of every pooled transaction, so charge for them up front
+    if (!tx->vout.empty())
+    {
+        tx->GetOutputDescriptor(0);
+    }
     nUsageSize = RecursiveDynamicUsage(*tx) + memusage::DynamicUsage(tx);
     feeRate = CFeeRate(nFee, nTxSize);
 }
@@ -61,7 +68,7 @@ CTxMemPoolEntry::GetPriority(unsigned int currentHeight) const
 }
 
 CTxMemPool::CTxMemPool(const CFeeRate& _minRelayFee) :
-    nTransactionsUpdated(0)
+    nTransactionsUpdated(0), minReasonableRelayFee(_minRelayFee)
 {
     // Sanity checks off by default for performance, because otherwise
     // accepting transactions becomes O(N^2) where N is the number
@@ -69,6 +76,10 @@ CTxMemPool::CTxMemPool(const CFeeRate& _minRelayFee) :
     nCheckFrequency = 0;
 
     minerPolicyEstimator = new CBlockPolicyEstimator(_minRelayFee);
+
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = false;
+    rollingMinimumFeeRate = 0;
 }
 
 CTxMemPool::~CTxMemPool()
@@ -123,8 +134,14 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     // Used by main.cpp AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     LOCK(cs);
-    mapTx.insert(entry);
-    const CTransaction& tx = mapTx.find(hash)->GetTx();
+    indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
+    // deltas from prioritisetransaction before the transaction arrived count in its modified fee
+    std::map<uint256, std::pair<double, CAmount> >::const_iterator pos = mapDeltas.find(hash);
+    if (pos != mapDeltas.end() && pos->second.second)
+    {
+        mapTx.modify(newit, update_fee_delta(pos->second.second));
+    }
+    const CTransaction& tx = newit->GetTx();
     mapRecentlyAddedTx[tx.GetHash()] = &tx;
     nRecentlyAddedSequence += 1;
     if (!tx.IsCoinImport()) {
@@ -828,6 +845,8 @@ void CTxMemPool::removeForBlock(const std::vector<CTransaction>& vtx, unsigned i
     }
     // After the txs in the new block have been removed from the mempool, update policy estimates
     minerPolicyEstimator->processBlock(nBlockHeight, entries, fCurrentEstimate);
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = true;
 }
 
 /**
@@ -868,6 +887,9 @@ void CTxMemPool::clear()
     mapSaplingNullifiers.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = false;
+    rollingMinimumFeeRate = 0;
     ++nTransactionsUpdated;
 }
 
@@ -1098,6 +1120,11 @@ void CTxMemPool::PrioritiseTransaction(const uint256 &hash, const string strHash
         std::pair<double, CAmount> &deltas = mapDeltas[hash];
         deltas.first += dPriorityDelta;
         deltas.second += nFeeDelta;
+        indexed_transaction_set::iterator it = mapTx.find(hash);
+        if (it != mapTx.end())
+        {
+            mapTx.modify(it, update_fee_delta(deltas.second));
+        }
     }
     if (fDebug)
     {
@@ -1259,5 +1286,183 @@ bool CCoinsViewMemPool::HaveCoins(const uint256 &txid) const {
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 6 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 6 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapDeltas) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 6 * sizeof(void*)) * mapTx.size() +
+           memusage::DynamicUsage(mapNextTx) +
+           memusage::DynamicUsage(mapDeltas) +
+           memusage::DynamicUsage(mapReserveTransactions) +
+           memusage::DynamicUsage(mapRecentlyAddedTx) +
+           memusage::DynamicUsage(mapSproutNullifiers) +
+           memusage::DynamicUsage(mapSaplingNullifiers) +
+           cachedInnerUsage;
+}
+
+void CTxMemPool::CalculateDescendants(const uint256 &hash, std::set<uint256> &setDescendants) const
+{
+    LOCK(cs);
+    std::deque<uint256> toVisit;
+    if (mapTx.count(hash) && setDescendants.insert(hash).second)
+    {
+        toVisit.push_back(hash);
+    }
+    while (!toVisit.empty())
+    {
+        uint256 oneHash = toVisit.front();
+        toVisit.pop_front();
+        std::map<COutPoint, CInPoint>::const_iterator it = mapNextTx.lower_bound(COutPoint(oneHash, 0));
+        for (; it != mapNextTx.end() && it->first.hash == oneHash; it++)
+        {
+            uint256 childHash = it->second.ptx->GetHash();
+            if (setDescendants.insert(childHash).second)
+            {
+                toVisit.push_back(childHash);
+            }
+        }
+    }
+}
+
+CAmount CTxMemPool::GetNativeEquivalentFee(const CTxMemPoolEntry &entry, const CCurrencyState &feeConversionState) const
+{
+    LOCK(cs);
+    auto it = mapReserveTransactions.find(entry.GetTx().GetHash());
+    if (it != mapReserveTransactions.end() && it->second.IsValid() && feeConversionState.IsValid())
+    {
+        return std::max(entry.GetFee(), it->second.AllFeesAsNative(feeConversionState));
+    }
+    return entry.GetFee();
+}
+
+bool CTxMemPool::IsEvictionExempt(const uint256 &hash) const
+{
+    LOCK(cs);
+    auto it = mapReserveTransactions.find(hash);
+    return it != mapReserveTransactions.end() &&
+           it->second.IsValid() &&
+           (it->second.IsImport() || it->second.IsExport() || it->second.IsNotaryPrioritized());
+}
+
+CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const
+{
+    LOCK(cs);
+    if (!blockSinceLastRollingFeeBump || rollingMinimumFeeRate == 0)
+        return CFeeRate(rollingMinimumFeeRate);
+
+    int64_t time = GetTime();
+    if (time > lastRollingFeeUpdate + 10) {
+        double halflife = ROLLING_FEE_HALFLIFE;
+        if (DynamicMemoryUsage() < sizelimit / 4)
+            halflife /= 4;
+        else if (DynamicMemoryUsage() < sizelimit / 2)
+            halflife /= 2;
+
+        rollingMinimumFeeRate = rollingMinimumFeeRate / pow(2.0, (time - lastRollingFeeUpdate) / halflife);
+        lastRollingFeeUpdate = time;
+
+        if (rollingMinimumFeeRate < (double)minReasonableRelayFee.GetFeePerK() / 2) {
+            rollingMinimumFeeRate = 0;
+            return CFeeRate(0);
+        }
+    }
+    return std::max(CFeeRate(rollingMinimumFeeRate), minReasonableRelayFee);
+}
+
+void CTxMemPool::trackPackageRemoved(const CFeeRate& rate)
+{
+    AssertLockHeld(cs);
+    if (rate.GetFeePerK() > rollingMinimumFeeRate) {
+        rollingMinimumFeeRate = rate.GetFeePerK();
+        blockSinceLastRollingFeeBump = false;
+    }
+}
+
+void CTxMemPool::TrimToSize(size_t sizelimit, const CCurrencyState &feeConversionState, std::vector<uint256>* pvNoSpendsRemaining)
+{
+    LOCK(cs);
+
+    unsigned nTxnRemoved = 0;
+    CFeeRate maxFeeRateRemoved(0);
+    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit)
+    {
+        // among the lowest modified fee rate entries, evict the descendant package that pays the least once reserve fees
+        // are converted. like a descendant score, a package is valued at no less than the rate of its root, so a cheap
+        // child does not get a well paying parent evicted, while a cheap parent is not protected by its children.
+        // a transaction is valued at the greater of its converted fees and its modified fee, since reserve transactions
+        // already carry their native fees as a delta from PrioritiseReserveTransaction.
+        std::set<uint256> setEvict;
+        CFeeRate evictRate;
+        int nCandidates = 0;
+        for (auto it = mapTx.get<1>().rbegin(); it != mapTx.get<1>().rend() && nCandidates < TRIM_CANDIDATES; it++)
+        {
+            std::set<uint256> setPackage;
+            CalculateDescendants(it->GetTx().GetHash(), setPackage);
+
+            CAmount packageFees = 0;
+            size_t packageSize = 0;
+            bool fExempt = false;
+            for (auto &oneHash : setPackage)
+            {
+                if (IsEvictionExempt(oneHash))
+                {
+                    fExempt = true;
+                    break;
+                }
+                indexed_transaction_set::const_iterator entryIt = mapTx.find(oneHash);
+                packageFees += std::max(GetNativeEquivalentFee(*entryIt, feeConversionState), entryIt->GetModifiedFee());
+                packageSize += entryIt->GetTxSize();
+            }
+            if (fExempt)
+            {
+                continue;
+            }
+            nCandidates++;
+
+            CAmount rootFee = std::max(GetNativeEquivalentFee(*it, feeConversionState), it->GetModifiedFee());
+            CFeeRate packageRate = std::max(CFeeRate(rootFee, it->GetTxSize()), CFeeRate(packageFees, packageSize));
+            if (setEvict.empty() || packageRate < evictRate)
+            {
+                setEvict.swap(setPackage);
+                evictRate = packageRate;
+            }
+        }
+
+        // the rest of the pool is exempt
+        if (setEvict.empty())
+        {
+            break;
+        }
+
+        // the rolling minimum must exceed the evicted rate, or the same package could immediately re-enter
+        CFeeRate removedRate(evictRate.GetFeePerK() + minReasonableRelayFee.GetFeePerK());
+        trackPackageRemoved(removedRate);
+        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removedRate);
+
+        std::vector<CTransaction> txn;
+        for (auto &oneHash : setEvict)
+        {
+            txn.push_back(mapTx.find(oneHash)->GetTx());
+        }
+        for (auto &oneTx : txn)
+        {
+            std::list<CTransaction> removed;
+            remove(oneTx, removed, false);
+        }
+        nTxnRemoved += txn.size();
+
+        if (pvNoSpendsRemaining)
+        {
+            for (auto &oneTx : txn)
+            {
+                for (const CTxIn& txin : oneTx.vin)
+                {
+                    if (exists(txin.prevout.hash))
+                        continue;
+                    std::map<COutPoint, CInPoint>::iterator it = mapNextTx.lower_bound(COutPoint(txin.prevout.hash, 0));
+                    if (it == mapNextTx.end() || it->first.hash != txin.prevout.hash)
+                        pvNoSpendsRemaining->push_back(txin.prevout.hash);
+                }
+            }
+        }
+    }
+
+    if (maxFeeRateRemoved > CFeeRate(0))
+        LogPrint("mempool", "Removed %u txn, rolling minimum fee bumped to %s\n", nTxnRemoved, maxFeeRateRemoved.ToString());
 }
@@ -39,6 +39,8 @@ inline bool AllowFree(double dPriority)
 
 /** Fake height value used in CCoins to signify they are only in the memory pool (since 0.8) */
 static const unsigned int MEMPOOL_HEIGHT = 0x7FFFFFFF;
+/** Default for -maxmempool, maximum megabytes of mempool memory usage */
+static const unsigned int DEFAULT_MAX_MEMPOOL_SIZE = 300;
 
 /**
  * CTxMemPool stores these:
@@ -105,14 +107,20 @@ struct mempoolentry_txid
     }
 };
 
+/** \class CompareTxMemPoolEntryByFee
+ *
+ *  Sort by modified fee rate ((fee+delta)/size) in descending order, oldest first on ties
+ */
 class CompareTxMemPoolEntryByFee
 {
 public:
-    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b)
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
     {
-        if (a.GetFeeRate() == b.GetFeeRate())
+        double f1 = (double)a.GetModifiedFee() * b.GetTxSize();
+        double f2 = (double)b.GetModifiedFee() * a.GetTxSize();
+        if (f1 == f2)
             return a.GetTime() < b.GetTime();
-        return a.GetFeeRate() > b.GetFeeRate();
+        return f1 > f2;
     }
 };
 
@@ -185,6 +193,13 @@ private:
     uint64_t totalTxSize = 0;  //!< sum of all mempool tx' byte sizes
     uint64_t cachedInnerUsage; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
 
+    CFeeRate minReasonableRelayFee;           //!< increment added to the fee rate of evicted packages
+    mutable int64_t lastRollingFeeUpdate;
+    mutable bool blockSinceLastRollingFeeBump;
+    mutable double rollingMinimumFeeRate;     //!< minimum fee to get into the pool, decreases exponentially
+
+    void trackPackageRemoved(const CFeeRate& rate);
+
     std::map<uint256, const CTransaction*> mapRecentlyAddedTx;
     uint64_t nRecentlyAddedSequence = 0;
     uint64_t nNotifiedSequence = 0;
@@ -198,12 +213,15 @@ private:
     void checkNullifiers(ShieldedType type) const;
 
 public:
+    static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12; // public only for testing
+    static const int TRIM_CANDIDATES = 16;                 // lowest fee rate entries considered per eviction
+
     typedef boost::multi_index_container<
         CTxMemPoolEntry,
         boost::multi_index::indexed_by<
             // sorted by txid
             boost::multi_index::ordered_unique<mempoolentry_txid>,
-            // sorted by fee rate
+            // sorted by modified fee rate
             boost::multi_index::ordered_non_unique<
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByFee
@@ -276,6 +294,33 @@ public:
 
     bool nullifierExists(const uint256& nullifier, ShieldedType type) const;
 
+    /** Populate setDescendants with hash and all in-mempool transactions that spend its outputs, directly or indirectly */
+    void CalculateDescendants(const uint256 &hash, std::set<uint256> &setDescendants) const;
+
+    /**
+     * Fee of a mempool entry in native currency. Reserve currency fees of reserve transactions are converted to native at
+     * the prices of feeConversionState, so that transactions paying fees in reserves compete fairly for space in the pool.
+     */
+    CAmount GetNativeEquivalentFee(const CTxMemPoolEntry &entry, const CCurrencyState &feeConversionState) const;
+
+    /** Imports, exports and notary prioritized transactions are accepted without a fee, and are never evicted */
+    bool IsEvictionExempt(const uint256 &hash) const;
+
+    /**
+     * The minimum fee rate to get into the mempool, which may itself not be enough for larger-sized transactions.
+     * It rises when packages are evicted by TrimToSize and decays back to zero with a half life of ROLLING_FEE_HALFLIFE
+     * once a block has been connected, faster while the pool is well below its limit.
+     */
+    CFeeRate GetMinFee(size_t sizelimit) const;
+
+    /**
+     * Remove transactions from the mempool until its dynamic size is <= sizelimit, evicting the descendant package of
+     * the cheapest transaction by modified fee rate first. Packages that include an eviction exempt transaction are
+     * kept. pvNoSpendsRemaining, if set, will be populated with the list of transactions which are not in mempool which
+     * no longer have any spends in this mempool.
+     */
+    void TrimToSize(size_t sizelimit, const CCurrencyState &feeConversionState, std::vector<uint256>* pvNoSpendsRemaining = NULL);
+
     void NotifyRecentlyAdded();
     bool IsFullyNotified();
 
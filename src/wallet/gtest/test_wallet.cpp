@@ -540,6 +540,12 @@ TEST(WalletTests, FindMySaplingNotes) {
     noteMap = wallet.FindMySaplingNotes(wtx).first;
     EXPECT_EQ(2, noteMap.size());
 
+    // Trial decrypting with the wallet's viewing key outside of the wallet, as a rescan does, finds the same notes
+    std::vector<libzcash::SaplingIncomingViewingKey> ivks {extfvk.fvk.in_viewing_key()};
+    auto noteMapWithKeys = CWallet::FindSaplingNotesWithKeys(wtx, ivks).first;
+    EXPECT_TRUE(noteMap == noteMapWithKeys);
+    EXPECT_EQ(0, CWallet::FindSaplingNotesWithKeys(wtx, {}).first.size());
+
     // Revert to default
     RegtestDeactivateSapling();
 }
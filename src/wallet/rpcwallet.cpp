@@ -5580,6 +5580,14 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp)
             sample_times.push_back(benchmark_verify_sapling_spend());
         } else if (benchmarktype == "verifysaplingoutput") {
             sample_times.push_back(benchmark_verify_sapling_output());
+        } else if (benchmarktype == "currencyvaluemap" || benchmarktype == "currencyvaluemaplegacy") {
+            int nCurrencies = 2;
+            if (params.size() >= 3) {
+                nCurrencies = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_currency_value_map(nCurrencies, benchmarktype == "currencyvaluemaplegacy"));
+        } else if (benchmarktype == "blockheaderhashes") {
+            sample_times.push_back(benchmark_block_header_hashes());
         } else {
             throw JSONRPCError(RPC_TYPE_ERROR, "Invalid benchmarktype");
         }
@@ -1406,23 +1406,10 @@ void CopyPreviousWitnesses(NoteDataMap& noteDataMap, int indexHeight, int64_t nW
     }
 }
 
-template<typename NoteDataMap>
-void AppendNoteCommitment(NoteDataMap& noteDataMap, int indexHeight, int64_t nWitnessCacheSize, const uint256& note_commitment)
-{
-    for (auto& item : noteDataMap) {
-        auto* nd = &(item.second);
-        if (nd->witnessHeight < indexHeight && nd->witnesses.size() > 0) {
-            // Check the validity of the cache
-            // See comment in CopyPreviousWitnesses about validity.
-            assert(nWitnessCacheSize >= nd->witnesses.size());
-            nd->witnesses.front().append(note_commitment);
-        }
-    }
-}
-
 template<typename OutPoint, typename NoteData, typename Witness>
-void WitnessNoteIfMine(std::map<OutPoint, NoteData>& noteDataMap, int indexHeight, int64_t nWitnessCacheSize, const OutPoint& key, const Witness& witness)
+NoteData *WitnessNoteIfMine(std::map<OutPoint, NoteData>& noteDataMap, int indexHeight, int64_t nWitnessCacheSize, const OutPoint& key, const Witness& witness, bool& fReplaced)
 {
+    fReplaced = false;
     if (noteDataMap.count(key) && noteDataMap[key].witnessHeight < indexHeight) {
         auto* nd = &(noteDataMap[key]);
         if (nd->witnesses.size() > 0) {
@@ -1441,12 +1428,94 @@ void WitnessNoteIfMine(std::map<OutPoint, NoteData>& noteDataMap, int indexHeigh
                         indexHeight,
                         witness.root().GetHex());
             nd->witnesses.clear();
+            fReplaced = true;
         }
         nd->witnesses.push_front(witness);
         // Set height to one less than pindex so it gets incremented
         nd->witnessHeight = indexHeight - 1;
         // Check the validity of the cache
         assert(nWitnessCacheSize >= nd->witnesses.size());
+        return nd;
+    }
+    return nullptr;
+}
+
+// notes whose newest witness is missing the commitments of the block being connected from the given position on
+template<typename NoteData>
+using NoteWitnessUpdates = std::vector<std::pair<NoteData*, size_t>>;
+
+template<typename NoteDataMap>
+void AddNoteWitnessUpdates(NoteDataMap& noteDataMap, int indexHeight, NoteWitnessUpdates<typename NoteDataMap::mapped_type>& updates)
+{
+    for (auto& item : noteDataMap) {
+        auto* nd = &(item.second);
+        if (nd->witnessHeight < indexHeight && nd->witnesses.size() > 0) {
+            updates.push_back(std::make_pair(nd, 0));
+        }
+    }
+}
+
+// a note witnessed by this block only takes the commitments after its own. a note whose witnesses were replaced is
+// already in the updates, which is rare enough to search for.
+template<typename NoteData>
+void SetNoteWitnessUpdate(NoteWitnessUpdates<NoteData>& updates, NoteData* nd, size_t nFirst, bool fReplaced)
+{
+    if (fReplaced) {
+        for (auto& update : updates) {
+            if (update.first == nd) {
+                update.second = nFirst;
+                return;
+            }
+        }
+    }
+    updates.push_back(std::make_pair(nd, nFirst));
+}
+
+const int MAX_WITNESS_THREADS = 8;
+const size_t MIN_PARALLEL_WITNESS_APPENDS = 1024;
+
+// appends the block's commitments to the newest witness of each note. notes are independent of each other, so when
+// there is enough work they are split between threads.
+template<typename NoteData>
+void AppendNoteCommitments(NoteWitnessUpdates<NoteData>& updates, const std::vector<uint256>& commitments, int64_t nWitnessCacheSize)
+{
+    auto appendRange = [&updates, &commitments, nWitnessCacheSize](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++) {
+            auto* nd = updates[i].first;
+            // Check the validity of the cache
+            // See comment in CopyPreviousWitnesses about validity.
+            assert(nWitnessCacheSize >= nd->witnesses.size());
+            for (size_t j = updates[i].second; j < commitments.size(); j++) {
+                nd->witnesses.front().append(commitments[j]);
+            }
+        }
+    };
+
+    int nThreads = std::max(1, std::min(GetNumCores(), MAX_WITNESS_THREADS));
+    if (nThreads == 1 || updates.size() < 2 || updates.size() * commitments.size() < MIN_PARALLEL_WITNESS_APPENDS) {
+        appendRange(0, updates.size());
+        return;
+    }
+    nThreads = std::min((size_t)nThreads, updates.size());
+
+    boost::mutex errorMutex;
+    std::string strError;
+    boost::thread_group appenders;
+    for (int i = 0; i < nThreads; i++) {
+        size_t begin = (i * updates.size()) / nThreads, end = ((i + 1) * updates.size()) / nThreads;
+        appenders.create_thread([&appendRange, &errorMutex, &strError, begin, end]() {
+            try {
+                appendRange(begin, end);
+            } catch (const std::exception& e) {
+                boost::unique_lock<boost::mutex> lock(errorMutex);
+                strError = e.what();
+            }
+        });
+    }
+    appenders.join_all();
+    if (!strError.empty()) {
+        throw std::runtime_error(strError);
     }
 }
 
@@ -1487,25 +1556,38 @@ void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
         pblock = &block;
     }
 
+    // Rather than appending each commitment to every witness as it is added
+    // to the tree, collect the block's commitments and the notes they are
+    // missing from, and append them to each note's witness afterwards.
+    NoteWitnessUpdates<SproutNoteData> sproutUpdates;
+    NoteWitnessUpdates<SaplingNoteData> saplingUpdates;
+    for (std::pair<const uint256, CWalletTx>& wtxItem : mapWallet) {
+        ::AddNoteWitnessUpdates(wtxItem.second.mapSproutNoteData, pindex->GetHeight(), sproutUpdates);
+        ::AddNoteWitnessUpdates(wtxItem.second.mapSaplingNoteData, pindex->GetHeight(), saplingUpdates);
+    }
+    std::vector<uint256> sproutCommitments;
+    std::vector<uint256> saplingCommitments;
+
     for (const CTransaction& tx : pblock->vtx) {
         auto hash = tx.GetHash();
-        bool txIsOurs = mapWallet.count(hash);
+        auto txIt = mapWallet.find(hash);
+        bool txIsOurs = txIt != mapWallet.end();
         // Sprout
         for (size_t i = 0; i < tx.vJoinSplit.size(); i++) {
             const JSDescription& jsdesc = tx.vJoinSplit[i];
             for (uint8_t j = 0; j < jsdesc.commitments.size(); j++) {
                 const uint256& note_commitment = jsdesc.commitments[j];
                 sproutTree.append(note_commitment);
-
-                // Increment existing witnesses
-                for (std::pair<const uint256, CWalletTx>& wtxItem : mapWallet) {
-                    ::AppendNoteCommitment(wtxItem.second.mapSproutNoteData, pindex->GetHeight(), nWitnessCacheSize, note_commitment);
-                }
+                sproutCommitments.push_back(note_commitment);
 
                 // If this is our note, witness it
                 if (txIsOurs) {
                     JSOutPoint jsoutpt {hash, i, j};
-                    ::WitnessNoteIfMine(mapWallet[hash].mapSproutNoteData, pindex->GetHeight(), nWitnessCacheSize, jsoutpt, sproutTree.witness());
+                    bool fReplaced;
+                    auto* nd = ::WitnessNoteIfMine(txIt->second.mapSproutNoteData, pindex->GetHeight(), nWitnessCacheSize, jsoutpt, sproutTree.witness(), fReplaced);
+                    if (nd) {
+                        ::SetNoteWitnessUpdate(sproutUpdates, nd, sproutCommitments.size(), fReplaced);
+                    }
                 }
             }
         }
@@ -1513,20 +1595,24 @@ void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
         for (uint32_t i = 0; i < tx.vShieldedOutput.size(); i++) {
             const uint256& note_commitment = tx.vShieldedOutput[i].cm;
             saplingTree.append(note_commitment);
-
-            // Increment existing witnesses
-            for (std::pair<const uint256, CWalletTx>& wtxItem : mapWallet) {
-                ::AppendNoteCommitment(wtxItem.second.mapSaplingNoteData, pindex->GetHeight(), nWitnessCacheSize, note_commitment);
-            }
+            saplingCommitments.push_back(note_commitment);
 
             // If this is our note, witness it
             if (txIsOurs) {
                 SaplingOutPoint outPoint {hash, i};
-                ::WitnessNoteIfMine(mapWallet[hash].mapSaplingNoteData, pindex->GetHeight(), nWitnessCacheSize, outPoint, saplingTree.witness());
+                bool fReplaced;
+                auto* nd = ::WitnessNoteIfMine(txIt->second.mapSaplingNoteData, pindex->GetHeight(), nWitnessCacheSize, outPoint, saplingTree.witness(), fReplaced);
+                if (nd) {
+                    ::SetNoteWitnessUpdate(saplingUpdates, nd, saplingCommitments.size(), fReplaced);
+                }
             }
         }
     }
 
+    // Increment existing witnesses
+    ::AppendNoteCommitments(sproutUpdates, sproutCommitments, nWitnessCacheSize);
+    ::AppendNoteCommitments(saplingUpdates, saplingCommitments, nWitnessCacheSize);
+
     // Update witness heights
     for (std::pair<const uint256, CWalletTx>& wtxItem : mapWallet) {
         ::UpdateWitnessHeights(wtxItem.second.mapSproutNoteData, pindex->GetHeight(), nWitnessCacheSize);
@@ -2677,7 +2763,8 @@ bool CWallet::MarkIdentityDirty(const CIdentityID &idID)
  * updated; instead, the transaction being in the mempool or conflicted is determined on
  * the fly in CMerkleTx::GetDepthInMainChain().
  */
-bool CWallet::AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate, bool isRescan)
+bool CWallet::AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate, bool isRescan,
+                                       const std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> *pSaplingNotes)
 {
     {
         AssertLockHeld(cs_wallet);
@@ -2688,10 +2775,14 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pbl
         bool isNewID = false;
         if (fExisted && !fUpdate) return false;
         auto sproutNoteData = FindMySproutNotes(tx);
-        auto saplingNoteDataAndAddressesToAdd = FindMySaplingNotes(tx);
+        // a rescan may already have trial decrypted the transaction on another thread
+        auto saplingNoteDataAndAddressesToAdd = pSaplingNotes ? *pSaplingNotes : FindMySaplingNotes(tx);
         auto saplingNoteData = saplingNoteDataAndAddressesToAdd.first;
         auto addressesToAdd = saplingNoteDataAndAddressesToAdd.second;
         for (const auto &addressToAdd : addressesToAdd) {
+            if (pSaplingNotes && HaveSaplingIncomingViewingKey(addressToAdd.first)) {
+                continue;
+            }
             if (!AddSaplingIncomingViewingKey(addressToAdd.second, addressToAdd.first)) {
                 return false;
             }
@@ -3591,6 +3682,34 @@ mapSproutNoteData_t CWallet::FindMySproutNotes(const CTransaction &tx) const
 std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> CWallet::FindMySaplingNotes(const CTransaction &tx) const
 {
     LOCK(cs_KeyStore);
+
+    std::vector<SaplingIncomingViewingKey> ivks;
+    ivks.reserve(mapSaplingFullViewingKeys.size());
+    for (auto it = mapSaplingFullViewingKeys.begin(); it != mapSaplingFullViewingKeys.end(); ++it) {
+        ivks.push_back(it->first);
+    }
+
+    auto noteDataAndAddresses = FindSaplingNotesWithKeys(tx, ivks);
+    for (auto it = noteDataAndAddresses.second.begin(); it != noteDataAndAddresses.second.end(); ) {
+        if (mapSaplingIncomingViewingKeys.count(it->first)) {
+            it = noteDataAndAddresses.second.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return noteDataAndAddresses;
+}
+
+/**
+ * Trial decrypts the Sapling outputs of tx with each of ivks in order, without
+ * reference to the wallet, so it may be called from any thread. Unlike
+ * FindMySaplingNotes, the addresses of all decrypted notes are returned, whether
+ * or not the wallet already has them.
+ */
+std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> CWallet::FindSaplingNotesWithKeys(
+    const CTransaction &tx,
+    const std::vector<SaplingIncomingViewingKey> &ivks)
+{
     uint256 hash = tx.GetHash();
 
     mapSaplingNoteData_t noteData;
@@ -3598,15 +3717,14 @@ std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> CWallet::FindMySap
 
     // Protocol Spec: 4.19 Block Chain Scanning (Sapling)
     for (uint32_t i = 0; i < tx.vShieldedOutput.size(); ++i) {
-        const OutputDescription output = tx.vShieldedOutput[i];
-        for (auto it = mapSaplingFullViewingKeys.begin(); it != mapSaplingFullViewingKeys.end(); ++it) {
-            SaplingIncomingViewingKey ivk = it->first;
+        const OutputDescription &output = tx.vShieldedOutput[i];
+        for (const SaplingIncomingViewingKey &ivk : ivks) {
             auto result = SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cm);
             if (!result) {
                 continue;
             }
             auto address = ivk.address(result.get().d);
-            if (address && mapSaplingIncomingViewingKeys.count(address.get()) == 0) {
+            if (address) {
                 viewingKeysToAdd[address.get()] = ivk;
             }
             // We don't cache the nullifier here as computing it requires knowledge of the note position
@@ -4409,6 +4527,110 @@ void CWallet::WitnessNoteCommitment(std::vector<uint256> commitments,
     }
 }
 
+namespace {
+
+const int MAX_RESCAN_THREADS = 8;
+const size_t MAX_RESCAN_BLOCKS_AHEAD = 64;
+
+// a block read by the rescan pipeline, with the Sapling notes found in each of its transactions
+struct CRescanBlock
+{
+    CBlock block;
+    std::vector<std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap>> saplingNotes;
+};
+
+// reads the blocks of a rescan ahead of the thread that adds their transactions to the wallet, and trial decrypts their
+// Sapling outputs with the wallet's viewing keys on as many threads as there are cores
+class CRescanPipeline
+{
+public:
+    CRescanPipeline(const std::vector<CBlockIndex *> &blockIndexes, const std::vector<SaplingIncomingViewingKey> &saplingIvks) :
+        vIndex(blockIndexes), ivks(saplingIvks), nNext(0), nTaken(0), fAbort(false)
+    {
+        int nThreads = std::max(1, std::min(GetNumCores(), MAX_RESCAN_THREADS));
+        for (int i = 0; i < nThreads; i++) {
+            workers.create_thread([this]() { Work(); });
+        }
+    }
+
+    ~CRescanPipeline()
+    {
+        Abort();
+        workers.join_all();
+    }
+
+    // waits for block n, which must be taken in order. null if the pipeline was aborted.
+    std::unique_ptr<CRescanBlock> Take(size_t n)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        std::map<size_t, std::unique_ptr<CRescanBlock>>::iterator it;
+        while (!fAbort && (it = ready.find(n)) == ready.end())
+            condReady.wait(lock);
+        if (fAbort)
+            return std::unique_ptr<CRescanBlock>();
+        std::unique_ptr<CRescanBlock> result = std::move(it->second);
+        ready.erase(it);
+        nTaken = n + 1;
+        condSpace.notify_all();
+        return result;
+    }
+
+    void Abort()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fAbort = true;
+        condSpace.notify_all();
+        condReady.notify_all();
+    }
+
+private:
+    void Work()
+    {
+        const Consensus::Params &consensus = Params().GetConsensus();
+        while (true) {
+            size_t n;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (!fAbort && nNext < vIndex.size() && nNext >= nTaken + MAX_RESCAN_BLOCKS_AHEAD)
+                    condSpace.wait(lock);
+                if (fAbort || nNext >= vIndex.size())
+                    return;
+                n = nNext++;
+            }
+
+            std::unique_ptr<CRescanBlock> result(new CRescanBlock());
+            try {
+                ReadBlockFromDisk(result->block, vIndex[n], consensus);
+                result->saplingNotes.reserve(result->block.vtx.size());
+                for (const CTransaction &tx : result->block.vtx) {
+                    result->saplingNotes.push_back(CWallet::FindSaplingNotesWithKeys(tx, ivks));
+                }
+            } catch (const std::exception &e) {
+                // the block is added to the wallet without the notes, which are then found when it is added
+                LogPrintf("%s: error scanning block %s: %s\n", __func__, vIndex[n]->GetBlockHash().GetHex(), e.what());
+                result->saplingNotes.clear();
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            ready[n] = std::move(result);
+            condReady.notify_all();
+        }
+    }
+
+    const std::vector<CBlockIndex *> &vIndex;
+    const std::vector<SaplingIncomingViewingKey> &ivks;
+    boost::mutex mutex;
+    boost::condition_variable condReady;
+    boost::condition_variable condSpace;
+    std::map<size_t, std::unique_ptr<CRescanBlock>> ready;
+    size_t nNext;
+    size_t nTaken;
+    bool fAbort;
+    boost::thread_group workers;
+};
+
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -4440,8 +4662,25 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
         ShowProgress(_("Rescanning..."), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
         double dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
         double dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.LastTip(), false);
-        while (pindex)
+
+        // blocks are read and trial decrypted by the pipeline's threads, while this thread adds their transactions to
+        // the wallet and updates the witness caches in chain order. the viewing keys cannot change while cs_KeyStore
+        // is held, so the pipeline's copy of them finds the same notes that FindMySaplingNotes would.
+        std::vector<CBlockIndex *> blockIndexes;
+        for (CBlockIndex *pscan = pindexStart; pscan; pscan = chainActive.Next(pscan)) {
+            blockIndexes.push_back(pscan);
+        }
+        std::vector<SaplingIncomingViewingKey> saplingIvks;
+        saplingIvks.reserve(mapSaplingFullViewingKeys.size());
+        for (auto it = mapSaplingFullViewingKeys.begin(); it != mapSaplingFullViewingKeys.end(); ++it) {
+            saplingIvks.push_back(it->first);
+        }
+        CRescanPipeline pipeline(blockIndexes, saplingIvks);
+
+        for (size_t nBlock = 0; nBlock < blockIndexes.size(); nBlock++)
         {
+            pindex = blockIndexes[nBlock];
+
             //exit loop if trying to shutdown
             if (ShutdownRequested()) {
                 break;
@@ -4450,11 +4689,16 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
             if (pindex->GetHeight() % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
 
-            CBlock block;
-            ReadBlockFromDisk(block, pindex, Params().GetConsensus());
-            BOOST_FOREACH(CTransaction& tx, block.vtx)
+            std::unique_ptr<CRescanBlock> scanned = pipeline.Take(nBlock);
+            if (!scanned) {
+                break;
+            }
+            CBlock &block = scanned->block;
+            bool haveNotes = scanned->saplingNotes.size() == block.vtx.size();
+            for (size_t i = 0; i < block.vtx.size(); i++)
             {
-                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate, true)) {
+                const CTransaction &tx = block.vtx[i];
+                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate, true, haveNotes ? &scanned->saplingNotes[i] : nullptr)) {
                     myTxHashes.push_back(tx.GetHash());
                     ret++;
                 }
@@ -4479,6 +4723,7 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
                 LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex ? pindex->GetHeight() : -1, Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
             }
         }
+        pipeline.Abort();
 
         // After rescanning, persist Sapling note data that might have changed, e.g. nullifiers.
         // Do not flush the wallet here for performance reasons.
@@ -17,6 +17,7 @@
 #include "consensus/validation.h"
 #include "main.h"
 #include "miner.h"
+#include "pbaas/crosschainrpc.h"
 #include "pow.h"
 #include "rpc/server.h"
 #include "script/sign.h"
@@ -429,7 +430,7 @@ double benchmark_increment_sapling_note_witnesses(size_t nTxs)
     {
         auto saplingTx = CreateSaplingTxWithNoteData(consensusParams, wallet, saplingSpendingKey);
         wallet.AddToWallet(saplingTx, true, NULL);
-        block1.vtx.push_back(saplingTx);
+        block2.vtx.push_back(saplingTx);
     }
 
     CBlockIndex index2(block2);
@@ -753,3 +754,142 @@ double benchmark_verify_sapling_output()
     }
     return timer_stop(tv_start);
 }
+
+// the std::map based CCurrencyValueMap arithmetic that the flat map replaced, kept as the baseline to compare against
+static std::map<uint160, int64_t> LegacyValueMapAdd(const std::map<uint160, int64_t> &a, const std::map<uint160, int64_t> &b)
+{
+    std::map<uint160, int64_t> retVal = a;
+    for (auto &oneVal : b)
+    {
+        retVal[oneVal.first] += oneVal.second;
+    }
+    return retVal;
+}
+
+static std::map<uint160, int64_t> LegacyValueMapSubtract(const std::map<uint160, int64_t> &a, const std::map<uint160, int64_t> &b)
+{
+    std::map<uint160, int64_t> retVal = a;
+    for (auto &oneVal : b)
+    {
+        retVal[oneVal.first] -= oneVal.second;
+    }
+    return retVal;
+}
+
+static std::map<uint160, int64_t> LegacyValueMapIntersecting(const std::map<uint160, int64_t> &a, const std::map<uint160, int64_t> &b)
+{
+    std::map<uint160, int64_t> retVal;
+    for (auto &oneVal : a)
+    {
+        auto it = b.find(oneVal.first);
+        if (it != b.end() && it->second != 0 && oneVal.second != 0)
+        {
+            retVal[oneVal.first] = oneVal.second;
+        }
+    }
+    return retVal;
+}
+
+static std::map<uint160, int64_t> LegacyValueMapNonIntersecting(const std::map<uint160, int64_t> &a, const std::map<uint160, int64_t> &b)
+{
+    std::map<uint160, int64_t> retVal = a;
+    for (auto &oneVal : a)
+    {
+        auto it = b.find(oneVal.first);
+        if (!oneVal.second || (it != b.end() && it->second != 0))
+        {
+            retVal.erase(oneVal.first);
+        }
+    }
+    return retVal;
+}
+
+// runs the operations that block connection, reserve transaction descriptors and the miner chain most often over
+// maps of nCurrencies currencies, either with CCurrencyValueMap or with the std::map implementation it replaced
+double benchmark_currency_value_map(size_t nCurrencies, bool fLegacy)
+{
+    const int nMaps = 1000;
+    std::vector<uint160> currencies;
+    for (size_t i = 0; i < nCurrencies * 2; i++)
+    {
+        uint256 seed = GetRandHash();
+        currencies.push_back(Hash160(seed.begin(), seed.end()));
+    }
+    std::vector<CCurrencyValueMap> maps(nMaps);
+    std::vector<std::map<uint160, int64_t>> legacyMaps(nMaps);
+    for (int i = 0; i < nMaps; i++)
+    {
+        for (size_t j = 0; j < nCurrencies; j++)
+        {
+            const uint160 &currencyID = currencies[GetRand(currencies.size())];
+            CAmount amount = GetRand(COIN) + 1;
+            maps[i].valueMap[currencyID] = amount;
+            legacyMaps[i][currencyID] = amount;
+        }
+    }
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    int64_t checksum = 0;
+    if (fLegacy)
+    {
+        std::map<uint160, int64_t> total;
+        for (int i = 1; i < nMaps; i++)
+        {
+            total = LegacyValueMapAdd(total, legacyMaps[i]);
+            std::map<uint160, int64_t> diff = LegacyValueMapSubtract(legacyMaps[i], legacyMaps[i - 1]);
+            checksum += LegacyValueMapIntersecting(diff, legacyMaps[i - 1]).size();
+            checksum += LegacyValueMapNonIntersecting(legacyMaps[i], legacyMaps[i - 1]).size();
+        }
+        checksum += total.size();
+    }
+    else
+    {
+        CCurrencyValueMap total;
+        for (int i = 1; i < nMaps; i++)
+        {
+            total += maps[i];
+            CCurrencyValueMap diff = maps[i] - maps[i - 1];
+            checksum += diff.IntersectingValues(maps[i - 1]).valueMap.size();
+            checksum += maps[i].NonIntersectingValues(maps[i - 1]).valueMap.size();
+        }
+        checksum += total.valueMap.size();
+    }
+    double ret = timer_stop(tv_start);
+    LogPrint("bench", "%s: checksum %d\n", __func__, checksum);
+    return ret;
+}
+
+// reads the chain tip from disk and processes it again as a duplicate block, which runs the same header hashing as a
+// new block up to the point where it is found to be known, and logs how many header hashes were requested and computed
+double benchmark_block_header_hashes()
+{
+    CBlock block;
+    int32_t nHeight;
+    uint64_t nCallsStart = CBlockHeader::nGetHashCalls, nHashesStart = CBlockHeader::nHashesComputed;
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    {
+        LOCK(cs_main);
+        CBlockIndex *pindex = chainActive.LastTip();
+        if (!pindex || !ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+        {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to read the chain tip");
+        }
+        nHeight = pindex->GetHeight();
+    }
+    uint64_t nReadCalls = CBlockHeader::nGetHashCalls - nCallsStart, nReadHashes = CBlockHeader::nHashesComputed - nHashesStart;
+
+    CValidationState state;
+    if (!ProcessNewBlock(false, nHeight, state, Params(), NULL, &block, true, NULL))
+    {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to process the chain tip");
+    }
+    double ret = timer_stop(tv_start);
+
+    LogPrintf("%s: ReadBlockFromDisk: %lu header hash calls, %lu computed, ProcessNewBlock: %lu header hash calls, %lu computed\n", __func__,
+              nReadCalls, nReadHashes,
+              CBlockHeader::nGetHashCalls - nCallsStart - nReadCalls, CBlockHeader::nHashesComputed - nHashesStart - nReadHashes);
+    return ret;
+}
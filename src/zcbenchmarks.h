@@ -24,5 +24,7 @@ extern double benchmark_create_sapling_spend();
 extern double benchmark_create_sapling_output();
 extern double benchmark_verify_sapling_spend();
 extern double benchmark_verify_sapling_output();
+extern double benchmark_currency_value_map(size_t nCurrencies, bool fLegacy);
+extern double benchmark_block_header_hashes();
 
 #endif
@@ -21,6 +21,11 @@ bool CZMQAbstractNotifier::NotifyBlock(const CBlock &)
     return true;
 }
 
+bool CZMQAbstractNotifier::NotifyBlockTemplate(const CBlock &)
+{
+    return true;
+}
+
 bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/)
 {
     return true;
@@ -34,6 +34,7 @@ public:
 
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyBlock(const CBlock& pblock);
+    virtual bool NotifyBlockTemplate(const CBlock &block);
     virtual bool NotifyTransaction(const CTransaction &transaction);
 
 protected:
@@ -14,6 +14,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_CHECKEDBLOCK = "checkedblock";
+static const char *MSG_BLOCKTEMPLATE = "blocktemplate";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -198,6 +199,16 @@ bool CZMQPublishCheckedBlockNotifier::NotifyBlock(const CBlock& block)
     return SendMessage(MSG_CHECKEDBLOCK, &(*ss.begin()), ss.size());
 }
 
+bool CZMQPublishBlockTemplateNotifier::NotifyBlockTemplate(const CBlock& block)
+{
+    LogPrint("zmq", "zmq: Publish blocktemplate on %s\n", block.hashPrevBlock.GetHex());
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+
+    return SendMessage(MSG_BLOCKTEMPLATE, &(*ss.begin()), ss.size());
+}
+
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
@@ -58,4 +58,10 @@ public:
     bool NotifyBlock(const CBlock &block);
 };
 
+class CZMQPublishBlockTemplateNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTemplate(const CBlock &block);
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H